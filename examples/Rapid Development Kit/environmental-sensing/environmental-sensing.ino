@@ -50,6 +50,14 @@ LoRaModem modem(loraSerial, debugSerial, credentials);  // Define LoRa modem pro
 Adafruit_BME280 tph1;                                   // Create an "tph" object which will be our TPH (Temperature, Pressure and Humidity) sensor
 BME280 tph2;
 CborPayload payload;                                    // Create an object for our cbor payload which will be used to send data to AllThingsTalk
+AssetRegistry assets;                                   // Keeps track of which values changed since they were last sent
+unsigned long heartbeat = 3600000;                      // Every value is sent at least once per hour (in milliseconds), even if it didn't change
+Asset<float> sound(assets, "12", 50, heartbeat);        // Asset "12" (Loudness sensor), only sent when it changes by more than 50
+Asset<float> light(assets, "6", 10, heartbeat);         // Asset "6" (Light sensor), only sent when it changes by more than 10 lux
+Asset<float> temperatureAsset(assets, "5", 0.5, heartbeat); // Asset "5" (Temperature sensor), only sent when it changes by more than 0.5 °C
+Asset<float> humidityAsset(assets, "11", 2, heartbeat); // Asset "11" (Humidity sensor), only sent when it changes by more than 2 %
+Asset<float> pressureAsset(assets, "10", 1, heartbeat); // Asset "10" (Pressure sensor), only sent when it changes by more than 1 hPa
+Asset<float> air(assets, "13", 20, heartbeat);          // Asset "13" (Air quality sensor), only sent when it changes by more than 20
 
 void setup() {                                          // This function runs only at boot and only once.
   debugSerial.begin(debugSerialBaud);                   // Initialize the debug serial port (for Serial monitor)
@@ -100,14 +108,15 @@ void readSensors() {                                    // Function that we'll c
 }
 
 void sendSensorValues() {                               // Function used to send the data we collected from all the sensors
-  payload.reset();                                      // Reset the cbor payload (in case there's anything left from the previous one)
-  payload.set("12", soundValue);                        // Create a payload containing data from the Sound Sensor to be sent to asset name "12" (Loudness sensor asser on AllThingsTalk Maker)
-  payload.set("6", lightValue);                         // Create a payload containing data from the Light Sensor to be sent to asset name "6" (Light sensor asset on AllThingsTalk Maker)
-  payload.set("5", temperature);                        // Create a payload containing data from the Temperature Sensor (TPH) to be sent to asset name "5" (Temperature sensor asset on AllThingsTalk Maker)
-  payload.set("11", humidity);                          // Create a payload containing data from the Humidity Sensor (TPH) to be sent to asset name "11" (Humidity sensor asset on AllThingsTalk Maker)
-  payload.set("10", pressure);                          // Create a payload containing data from the Pressure Sensor (TPH) to be sent to asset name "10" (Pressure sensor asset on AllThingsTalk Maker)
-  payload.set("13", airValue);                          // Create a payload containing data from the Air Quality (gas) Sensor to be sent to the asset name "13" (Air quality sensor asset on AllThingsTalk Maker)
-  modem.send(payload);                                  // Send all the data above to your AllThingsTalk account
+  sound.set(soundValue);                                // Hand the new readings to their assets
+  light.set(lightValue);
+  temperatureAsset.set(temperature);
+  humidityAsset.set(humidity);
+  pressureAsset.set(pressure);
+  air.set(airValue);
+  if (assets.build(payload) && modem.send(payload)) {   // Create a payload with only the values that changed (or weren't sent for an hour) and send it
+    assets.commit();                                    // Remember what was sent, so unchanged values are left out next time
+  }
 }
 
 void displaySensorValues() {                            // Function we'll call to output all the collected data via debug Serial (to see when you open Serial Monitor)
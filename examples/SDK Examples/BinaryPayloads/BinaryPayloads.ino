@@ -33,7 +33,9 @@
  *
  * The provided binary format neatly packs three values: a single precision
  * floating point number, a boolean value, and a string that's five characters
- * long.
+ * long. The layout is declared once as a Schema, which also prints the
+ * matching ABCL conversion to the serial monitor at startup, so the decoding
+ * logic on Maker can't drift from what the device sends.
 
  * For more details on how to work with custom binary files please refer to
  * docs.allthingstalk.com and search for Binary Data Please note you will have
@@ -67,12 +69,16 @@
 ABPCredentials credentials(DEVADDR, APPSKEY, NWKSKEY);
 LoRaModem modem(loraSerial, debugSerial, credentials);
 BinaryPayload payload;
+Schema<Field<float>, Field<bool>, Field<char[5]>> schema("random", "toggle", "message");
 bool toggle = false;
 
 void setup() {
   debugSerial.begin(57600);
   while ((!debugSerial)) {}
 
+  // Copy this into Settings > Payload formats on Maker.
+  schema.describe(debugSerial);
+
   if (!modem.init()) {
     exit(0);
   }
@@ -83,11 +89,9 @@ void loop() {
   toggle = !toggle;
 
   // We reset the payload, and in order, add a random number, the current value
-  // of "toggle", and a 5 character message.
+  // of "toggle", and a 5 character message, as laid out by the schema.
   payload.reset();
-  payload.add(randomNumber(0, 25));
-  payload.add(toggle);
-  payload.add("hello");
+  schema.encode(payload, randomNumber(0, 25), toggle, "hello");
 
   // Then we send the payload.
   modem.send(payload);
@@ -0,0 +1,102 @@
+/*    _   _ _ _____ _    _              _____     _ _     ___ ___  _  __
+ *   /_\ | | |_   _| |_ (_)_ _  __ _ __|_   _|_ _| | |__ / __|   \| |/ /
+ *  / _ \| | | | | | ' \| | ' \/ _` (_-< | |/ _` | | / / \__ \ |) | ' <
+ * /_/ \_\_|_| |_| |_||_|_|_||_\__, /__/ |_|\__,_|_|_\_\ |___/___/|_|\_\
+ *                             |___/
+ *
+ * Copyright 2019 AllThingsTalk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Before you start please ensure that both the library and the board is
+ * updated to the latest version.
+ *
+ ******************************************************************************
+ * About this example
+ ******************************************************************************
+ *
+ * In this example, we don't send any data to the AllThingsTalk Cloud. Instead,
+ * we encode the same CBOR frame many times, once with CborWriter (which
+ * writes through the virtual CborOutput interface) and once with
+ * CborWriterT<CborBufferSink> (which CborPayload uses), and print how long a
+ * frame takes with each.
+ */
+
+#include <AllThingsTalk_LoRaWAN.h>
+
+// This example supports both Sodaq ONE & Sodaq Mbili.
+// The code below helps us discover which one it is.
+
+#if defined(ARDUINO_SODAQ_ONE)
+  #define debugSerial SerialUSB
+#elif defined(ARDUINO_AVR_SODAQ_MBILI)
+  #define debugSerial Serial
+#else
+  #error "Unsupported board."
+#endif
+
+const unsigned int rounds = 1000;
+unsigned char buffer[51];
+
+// A typical frame: four assets of different types.
+template<typename Writer> void encode(Writer &writer) {
+  writer.writeMap(4);
+  writer.writeString("temperature", 11);
+  writer.writeFloat(21.5);
+  writer.writeString("count", 5);
+  writer.writeInt((uint32_t)1234);
+  writer.writeString("door", 4);
+  writer.writeSpecial(21); // true
+  writer.writeString("pressure", 8);
+  writer.writeFloat(1013.2);
+}
+
+void report(const char *name, unsigned long elapsed, unsigned int size) {
+  debugSerial.print(name);
+  debugSerial.print(": ");
+  debugSerial.print((float)elapsed / rounds);
+  debugSerial.print(" us per ");
+  debugSerial.print(size);
+  debugSerial.println(" byte frame");
+}
+
+void setup() {
+  // We initialize the serial connection so that we can show the results.
+  debugSerial.begin(57600);
+  while (!debugSerial) {}
+
+  unsigned int size = 0;
+  unsigned long start = micros();
+  for (unsigned int i = 0; i < rounds; i++) {
+    CborStaticOutput output(buffer, sizeof(buffer));
+    CborWriter writer(output);
+    encode(writer);
+    size = output.getSize();
+  }
+  report("CborWriter", micros() - start, size);
+
+  start = micros();
+  for (unsigned int i = 0; i < rounds; i++) {
+    CborBufferSink sink(buffer, sizeof(buffer));
+    CborWriterT<CborBufferSink> writer(sink);
+    encode(writer);
+    size = sink.getSize();
+  }
+  report("CborWriterT<CborBufferSink>", micros() - start, size);
+}
+
+void loop() {
+  // Put additional code here, to run repeatedly.
+}
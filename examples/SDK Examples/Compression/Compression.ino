@@ -0,0 +1,104 @@
+/*    _   _ _ _____ _    _              _____     _ _     ___ ___  _  __
+ *   /_\ | | |_   _| |_ (_)_ _  __ _ __|_   _|_ _| | |__ / __|   \| |/ /
+ *  / _ \| | | | | | ' \| | ' \/ _` (_-< | |/ _` | | / / \__ \ |) | ' <
+ * /_/ \_\_|_| |_| |_||_|_|_||_\__, /__/ |_|\__,_|_|_\_\ |___/___/|_|\_\
+ *                             |___/
+ *
+ * Copyright 2019 AllThingsTalk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Before you start please ensure that both the library and the board is
+ * updated to the latest version.
+ *
+ ******************************************************************************
+ * About this example
+ ******************************************************************************
+ *
+ * In this example, we don't send any data to the AllThingsTalk Cloud. Instead,
+ * we compress a few typical text frames and print how small they get and how
+ * long it takes, with and without a shared dictionary. Every frame is decoded
+ * again to check the result.
+ */
+
+#include <AllThingsTalk_LoRaWAN.h>
+
+// This example supports both Sodaq ONE & Sodaq Mbili.
+// The code below helps us discover which one it is.
+
+#if defined(ARDUINO_SODAQ_ONE)
+  #define debugSerial SerialUSB
+#elif defined(ARDUINO_AVR_SODAQ_MBILI)
+  #define debugSerial Serial
+#else
+  #error "Unsupported board."
+#endif
+
+// Words that show up in most frames. The backend decodes with the same bytes.
+const unsigned char dictionary[] = "statusmessageerrorfirmwareversionbatterytemperaturehumidity"
+                                   "sensortimeoutfailedconnectedokrestart";
+
+const char *frames[] = {
+  "sensor ok",
+  "error: sensor timeout after 3 retries",
+  "firmware version 1.4.2, battery 87%, status ok",
+  "restart: watchdog, last error: i2c timeout, i2c timeout, i2c timeout",
+};
+
+const int rounds = 20;
+
+void benchmark(const char *name, const unsigned char *dictionary, unsigned int dictionarySize) {
+  CborPayload payload(120);
+  CompressedPayload compressed(120, dictionary, dictionarySize);
+  unsigned char decoded[120];
+
+  debugSerial.println(name);
+  for (unsigned int i = 0; i < sizeof(frames) / sizeof(frames[0]); i++) {
+    payload.reset();
+    payload.set("message", frames[i]);
+
+    unsigned long start = micros();
+    for (int round = 0; round < rounds; round++) {
+      compressed.compress(payload);
+    }
+    unsigned long elapsed = (micros() - start) / rounds;
+
+    unsigned int size = CompressedPayload::decode(compressed.getBytes(), compressed.getSize(),
+                                                  decoded, sizeof(decoded), dictionary, dictionarySize);
+    bool ok = size == payload.getSize() && memcmp(decoded, payload.getBytes(), size) == 0;
+
+    debugSerial.print("  ");
+    debugSerial.print(payload.getSize());
+    debugSerial.print(" -> ");
+    debugSerial.print(compressed.getSize());
+    debugSerial.print(" bytes, ");
+    debugSerial.print(elapsed);
+    debugSerial.print(" us");
+    debugSerial.println(ok ? "" : ", DECODE FAILED");
+  }
+}
+
+void setup() {
+  // We initialize the serial connection so that we can show the results.
+  debugSerial.begin(57600);
+  while (!debugSerial) {}
+
+  benchmark("Without dictionary:", NULL, 0);
+  benchmark("With dictionary:", dictionary, sizeof(dictionary) - 1);
+}
+
+void loop() {
+  // Put additional code here, to run repeatedly.
+}
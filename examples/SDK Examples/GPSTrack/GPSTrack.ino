@@ -0,0 +1,99 @@
+/*    _   _ _ _____ _    _              _____     _ _     ___ ___  _  __
+ *   /_\ | | |_   _| |_ (_)_ _  __ _ __|_   _|_ _| | |__ / __|   \| |/ /
+ *  / _ \| | | | | | ' \| | ' \/ _` (_-< | |/ _` | | / / \__ \ |) | ' <
+ * /_/ \_\_|_| |_| |_||_|_|_||_\__, /__/ |_|\__,_|_|_\_\ |___/___/|_|\_\
+ *                             |___/
+ *
+ * Copyright 2019 AllThingsTalk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Before you start please ensure that both the library and the board is
+ * updated to the latest version.
+ *
+ ******************************************************************************
+ * About this example
+ ******************************************************************************
+ *
+ * In this example we implement a virtual GPS tracker that takes a fix every
+ * 30 seconds but doesn't send each one on its own. Fixes are collected in a
+ * TrackPayload, which stores the first one in full and the following ones as
+ * small differences, and the batch is sent once the next fix no longer fits
+ * in a single uplink. You are going to need a Sodaq ONE or Sodaq Mbili board.
+ * No sensors required.
+ *
+ * The batch is a binary format, so it's sent on its own port (2). Decode it
+ * on the receiving side with TrackReader from the SDK.
+ */
+
+#include <AllThingsTalk_LoRaWAN.h>
+
+#include "keys.h"
+
+// This example supports both Sodaq ONE & Sodaq Mbili.
+// The code below helps us discover which one it is.
+
+#if defined(ARDUINO_SODAQ_ONE)
+  #define debugSerial SerialUSB
+#elif defined(ARDUINO_AVR_SODAQ_MBILI)
+  #define debugSerial Serial
+#else
+  #error "Unsupported board."
+#endif
+#define loraSerial Serial1
+
+ABPCredentials credentials(DEVADDR, APPSKEY, NWKSKEY);
+LoRaModem modem(loraSerial, debugSerial, credentials);
+TrackPayload track;
+
+float latitude = 51.0543;
+float longitude = 3.7174;
+
+void setup() {
+  debugSerial.begin(57600);
+  while (!debugSerial) {}
+
+  if (!modem.init()) {
+    debugSerial.println("Could not initialize the modem. Check your keys.");
+    exit(0);
+  }
+
+  modem.setPort(2);
+}
+
+void loop() {
+  // In each iteration, we move our virtual tracker a few meters.
+  latitude += randomFloat(-0.0005, 0.0005);
+  longitude += randomFloat(-0.0005, 0.0005);
+  GeoLocation geoLocation(latitude, longitude);
+  uint32_t timestamp = millis() / 1000;
+
+  // If the fix doesn't fit in the current batch anymore, we send the batch
+  // and start a new one with this fix.
+  if (!track.add(geoLocation, timestamp)) {
+    debugSerial.print("Sending ");
+    debugSerial.print(track.getCount());
+    debugSerial.println(" fixes.");
+    modem.send(track);
+    track.reset();
+    track.add(geoLocation, timestamp);
+  }
+
+  delay(30000);
+}
+
+float randomFloat(float minf, float maxf) {
+  return minf + random(1UL << 15) * (maxf - minf) / (1UL << 15);
+}
@@ -0,0 +1,15 @@
+#ifndef KEYS_H
+#define KEYS_H
+
+//ABP Credentials
+uint8_t DEVADDR[4] = { };
+uint8_t APPSKEY[16] = { };
+uint8_t NWKSKEY[16] = { };
+
+
+//OTAA Credentials
+uint8_t DEVEUI[8] = { };
+uint8_t APPEUI[8] = { };
+uint8_t APPKEY[16] = { };
+
+#endif
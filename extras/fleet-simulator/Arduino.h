@@ -0,0 +1,78 @@
+#ifndef ARDUINO_H_
+#define ARDUINO_H_
+
+// Just enough of the Arduino core to build LoRaModem on a host, against an
+// emulated modem instead of a serial port.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+// Only what BinaryPayload and the CBOR writer use.
+class String {
+public:
+    String(const char *text = "") : text(text) { }
+
+    unsigned int length() const { return text.size(); }
+    const char *c_str() const { return text.c_str(); }
+    char operator[](unsigned int index) const { return text[index]; }
+
+private:
+    std::string text;
+};
+
+class Print {
+public:
+    virtual ~Print() { }
+
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *bytes, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            write(bytes[i]);
+        }
+        return size;
+    }
+
+    size_t print(const char *text) { return write(reinterpret_cast<const uint8_t *>(text), strlen(text)); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char value) { return print((unsigned long)value); }
+    size_t print(int value) { return print((long)value); }
+    size_t print(unsigned int value) { return print((unsigned long)value); }
+
+    size_t print(long value) {
+        char text[24];
+        return write(reinterpret_cast<const uint8_t *>(text), snprintf(text, sizeof(text), "%ld", value));
+    }
+
+    size_t print(unsigned long value) {
+        char text[24];
+        return write(reinterpret_cast<const uint8_t *>(text), snprintf(text, sizeof(text), "%lu", value));
+    }
+};
+
+class Stream : public Print {
+public:
+    virtual void setTimeout(unsigned long) { }
+    virtual void flush() { }
+    virtual size_t readBytesUntil(char, char *, size_t) { return 0; }
+};
+
+class HardwareSerial : public Stream {
+public:
+    virtual void begin(unsigned long) { }
+    operator bool() { return true; }
+};
+
+// Output that goes nowhere, for the modems' debug logs.
+class NullStream : public Stream {
+public:
+    virtual size_t write(uint8_t) { return 1; }
+    virtual size_t write(const uint8_t *, size_t size) { return size; }
+};
+
+inline void delay(unsigned long) { }
+
+#endif
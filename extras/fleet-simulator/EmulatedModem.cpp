@@ -0,0 +1,159 @@
+#include "EmulatedModem.h"
+
+// Application payload limits per EU868 data rate, as in LoRaModem.
+static const unsigned char payloadSizes[] = { 51, 51, 51, 115, 222, 222 };
+
+EmulatedModem::EmulatedModem(uint32_t node, unsigned int channelCount, float power, uint32_t seed) : random(seed) {
+    this->node = node;
+    this->channelCount = channelCount < maxChannels ? channelCount : maxChannels;
+    this->power = power;
+}
+
+size_t EmulatedModem::write(uint8_t c) {
+    if (c == '\n') {
+        line[lineSize] = 0;
+        handle(line);
+        lineSize = 0;
+    } else if (c != '\r' && lineSize < maxLineSize) {
+        line[lineSize++] = c;
+    }
+    return 1;
+}
+
+size_t EmulatedModem::readBytesUntil(char, char *buffer, size_t length) {
+    if (replies.empty())
+        return 0; // Timeout
+
+    // The terminator is dropped, the \r before it is not.
+    std::string &text = replies.front();
+    size_t size = text.size() + 1 < length ? text.size() + 1 : length;
+    memcpy(buffer, text.c_str(), size);
+    buffer[size - 1] = '\r';
+    replies.pop_front();
+    return size;
+}
+
+void EmulatedModem::reply(const char *text) {
+    replies.push_back(text);
+}
+
+void EmulatedModem::handle(char *command) {
+    char *words[5] = { 0 };
+    unsigned int count = 0;
+    // strtok would share its state between the simulator's threads.
+    for (char *word = command; *word && count < 5;) {
+        words[count++] = word;
+        char *space = strchr(word, ' ');
+        if (!space)
+            break;
+        *space = 0;
+        word = space + 1;
+    }
+    if (count == 0)
+        return;
+
+    if (count >= 2 && !strcmp(words[0], "sys") && !strcmp(words[1], "reset")) {
+        joined = false;
+        reply("RN2483 1.0.5 Oct 31 2018 15:06:52");
+    } else if (count >= 2 && !strcmp(words[0], "sys") && !strcmp(words[1], "sleep")) {
+        // Answers "ok" on waking up, which LoRaModem does not wait for.
+    } else if (count == 4 && !strcmp(words[0], "mac") && !strcmp(words[1], "set")) {
+        handleMacSet(words[2], words[3]);
+    } else if (count == 3 && !strcmp(words[0], "mac") && !strcmp(words[1], "get")) {
+        handleMacGet(words[2]);
+    } else if (count == 3 && !strcmp(words[0], "mac") && !strcmp(words[1], "join")) {
+        joined = true;
+        reply("ok");
+        reply("accepted");
+    } else if (count == 5 && !strcmp(words[0], "mac") && !strcmp(words[1], "tx")) {
+        int port = atoi(words[3]);
+        if ((strcmp(words[2], "uncnf") && strcmp(words[2], "cnf")) || port < 1 || port > 223) {
+            rejected++;
+            reply("invalid_param");
+        } else {
+            transmit(words[4]);
+        }
+    } else {
+        rejected++;
+        reply("invalid_param");
+    }
+}
+
+void EmulatedModem::handleMacSet(const char *name, const char *value) {
+    if (!strcmp(name, "dr")) {
+        unsigned int rate = atoi(value);
+        if (rate >= sizeof(payloadSizes)) {
+            rejected++;
+            reply("invalid_param");
+            return;
+        }
+        dataRate = rate;
+    } else if (!strcmp(name, "upctr")) {
+        uplinkCounter = strtoul(value, 0, 10);
+    } else if (!strcmp(name, "dnctr")) {
+        downlinkCounter = strtoul(value, 0, 10);
+    }
+    // Keys, addresses and adr are taken as they are.
+    reply("ok");
+}
+
+void EmulatedModem::handleMacGet(const char *name) {
+    char text[16];
+    if (!strcmp(name, "dr")) {
+        snprintf(text, sizeof(text), "%u", dataRate);
+    } else if (!strcmp(name, "adr")) {
+        snprintf(text, sizeof(text), "off");
+    } else if (!strcmp(name, "upctr")) {
+        snprintf(text, sizeof(text), "%lu", (unsigned long)uplinkCounter);
+    } else if (!strcmp(name, "dnctr")) {
+        snprintf(text, sizeof(text), "%lu", (unsigned long)downlinkCounter);
+    } else {
+        rejected++;
+        snprintf(text, sizeof(text), "invalid_param");
+    }
+    reply(text);
+}
+
+void EmulatedModem::transmit(const char *payload) {
+    size_t digits = strlen(payload);
+    if (!joined) {
+        rejected++;
+        reply("not_joined");
+        return;
+    }
+    if (digits % 2 != 0 || digits / 2 > payloadSizes[dataRate]) {
+        rejected++;
+        reply("invalid_data_len");
+        return;
+    }
+
+    unsigned int free[maxChannels];
+    unsigned int freeCount = 0;
+    for (unsigned int channel = 0; channel < channelCount; ++channel) {
+        if (bandFreeAt[channels[channel].band] <= now) {
+            free[freeCount++] = channel;
+        }
+    }
+    if (freeCount == 0) {
+        blocked++;
+        reply("no_free_ch");
+        return;
+    }
+
+    unsigned int channel = free[random() % freeCount];
+    unsigned int spreadingFactor = 12 - dataRate;
+    int64_t duration = airtime(spreadingFactor, digits / 2);
+    const SubBand &band = subBands[channels[channel].band];
+
+    // The sub-band rests until the uplink is the allowed share of the time.
+    bandFreeAt[channels[channel].band] = now + (int64_t)(duration / band.dutyCycle);
+    Transmission transmission = {
+        now, now + duration, node, (uint8_t)channel, (uint8_t)spreadingFactor, power,
+        canReceive(power, spreadingFactor)
+    };
+    transmissions.push_back(transmission);
+    uplinkCounter++;
+
+    reply("ok");
+    reply("mac_tx_ok");
+}
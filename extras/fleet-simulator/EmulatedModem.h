@@ -0,0 +1,56 @@
+#ifndef EMULATED_MODEM_H_
+#define EMULATED_MODEM_H_
+
+#include "Arduino.h"
+#include "Radio.h"
+
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+// An RN2483 as LoRaModem sees it over its serial port. Commands are answered
+// at once; the sketch moves the clock (now) between uplinks. Uplinks go on a
+// random enabled channel whose sub-band is out of its duty cycle off-time,
+// or are refused with no_free_ch, as the real modem does. Every uplink is
+// logged for the gateway; nothing is ever received, so confirmed uplinks go
+// out once and end with mac_tx_ok like unconfirmed ones.
+class EmulatedModem : public HardwareSerial {
+public:
+    EmulatedModem(uint32_t node, unsigned int channelCount, float power, uint32_t seed);
+
+    virtual size_t write(uint8_t c);
+    virtual size_t readBytesUntil(char terminator, char *buffer, size_t length);
+    using Print::write;
+
+    int64_t now = 0; // Microseconds
+    std::vector<Transmission> transmissions;
+    unsigned long blocked = 0;  // Uplinks refused with no_free_ch
+    unsigned long rejected = 0; // Other refused commands
+
+private:
+    static const unsigned int maxLineSize = 600;
+
+    uint32_t node;
+    unsigned int channelCount;
+    float power;
+    std::minstd_rand random;
+
+    char line[maxLineSize + 1];
+    unsigned int lineSize = 0;
+    std::deque<std::string> replies;
+
+    bool joined = false;
+    unsigned int dataRate = 0;
+    uint32_t uplinkCounter = 0;
+    uint32_t downlinkCounter = 0;
+    int64_t bandFreeAt[2] = { 0, 0 };
+
+    void handle(char *command);
+    void handleMacSet(const char *name, const char *value);
+    void handleMacGet(const char *name);
+    void transmit(const char *payload);
+    void reply(const char *text);
+};
+
+#endif
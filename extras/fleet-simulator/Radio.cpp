@@ -0,0 +1,54 @@
+#include "Radio.h"
+
+#include <math.h>
+
+const Channel channels[maxChannels] = {
+    { 868100000, 1 }, { 868300000, 1 }, { 868500000, 1 },
+    { 867100000, 0 }, { 867300000, 0 }, { 867500000, 0 }, { 867700000, 0 }, { 867900000, 0 },
+};
+
+// ETSI EN 300 220 sub-bands g (865-868 MHz) and g1 (868-868.6 MHz).
+const SubBand subBands[2] = {
+    { "g", 0.01 },
+    { "g1", 0.01 },
+};
+
+// MHDR, DevAddr, FCtrl, FCnt, FPort and MIC around the application payload.
+static const unsigned int frameOverhead = 13;
+
+static const double bandwidth = 125000;
+static const double transmitPower = 14;
+static const double noiseFigure = 6;
+
+// Demodulation floor per spreading factor (SX1276 datasheet), dB SNR.
+static const double snrLimits[] = { -7.5, -10, -12.5, -15, -17.5, -20 };
+
+int64_t airtime(unsigned int spreadingFactor, unsigned int payloadSize) {
+    double symbol = pow(2, spreadingFactor) / bandwidth;
+    double preamble = (8 + 4.25) * symbol;
+    int lowDataRate = spreadingFactor >= 11 ? 1 : 0;
+
+    double bits = 8.0 * (payloadSize + frameOverhead) - 4.0 * spreadingFactor + 28 + 16;
+    double blocks = ceil(bits / (4.0 * (spreadingFactor - 2 * lowDataRate)));
+    double symbols = 8 + (blocks > 0 ? blocks * 5 : 0);
+    return (int64_t)((preamble + symbols * symbol) * 1e6 + 0.5);
+}
+
+// 3GPP macro-cell path loss at 868 MHz: 128.1 + 37.6 log10(km).
+double receivedPower(double meters) {
+    double kilometers = meters < 10 ? 0.01 : meters / 1000;
+    return transmitPower - (128.1 + 37.6 * log10(kilometers));
+}
+
+bool canReceive(double power, unsigned int spreadingFactor, double margin) {
+    double noise = -174 + 10 * log10(bandwidth) + noiseFigure;
+    return power - noise - margin >= snrLimits[spreadingFactor - 7];
+}
+
+unsigned int lowestSpreadingFactor(double power, double margin) {
+    for (unsigned int spreadingFactor = 7; spreadingFactor < 12; ++spreadingFactor) {
+        if (canReceive(power, spreadingFactor, margin))
+            return spreadingFactor;
+    }
+    return 12;
+}
@@ -0,0 +1,50 @@
+#ifndef RADIO_H_
+#define RADIO_H_
+
+#include <stdint.h>
+
+// EU868 radio model shared by the emulated modems and the gateway.
+
+struct Channel {
+    uint32_t frequency;
+    uint8_t band; // Index into subBands
+};
+
+struct SubBand {
+    const char *name;
+    double dutyCycle;
+};
+
+// The three join channels every device has, then the five that networks
+// commonly add in the 867 MHz range.
+static const unsigned int maxChannels = 8;
+extern const Channel channels[maxChannels];
+extern const SubBand subBands[2];
+
+// One uplink as the gateway sees it. Times are in microseconds.
+struct Transmission {
+    int64_t start;
+    int64_t end;
+    uint32_t node;
+    uint8_t channel;
+    uint8_t spreadingFactor;
+    float power;     // Received power at the gateway, dBm
+    bool reachable;  // Above the sensitivity for its spreading factor
+};
+
+// Time on air of a LoRaWAN uplink with this many application bytes, at
+// 125 kHz, coding rate 4/5, with an explicit header and a CRC.
+int64_t airtime(unsigned int spreadingFactor, unsigned int payloadSize);
+
+// Received power at the gateway from a 14 dBm node at this distance.
+double receivedPower(double meters);
+
+// Whether a signal of this power can be demodulated at this spreading
+// factor, with margin dB to spare.
+bool canReceive(double power, unsigned int spreadingFactor, double margin = 0);
+
+// The fastest spreading factor that reaches the gateway with margin dB to
+// spare, or 12 if none does.
+unsigned int lowestSpreadingFactor(double power, double margin);
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef WORK_STEALING_POOL_H_
+#define WORK_STEALING_POOL_H_
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Runs task(begin, end) over [0, count) in chunks on a fixed set of threads.
+// Each worker is dealt a contiguous block of chunks and works through it from
+// the back; a worker that runs dry takes chunks from the front of another's
+// block, so a few slow chunks (uplinks on a crowded channel) do not leave the
+// other threads idle.
+class WorkStealingPool {
+public:
+    typedef std::function<void(size_t begin, size_t end)> Task;
+
+    explicit WorkStealingPool(unsigned int threadCount) : workers(threadCount > 0 ? threadCount : 1) { }
+
+    unsigned int getThreadCount() const { return workers.size(); }
+    unsigned long getSteals() const { return steals; }
+
+    void run(size_t count, size_t chunk, const Task &task) {
+        if (chunk == 0)
+            chunk = 1;
+
+        size_t chunks = (count + chunk - 1) / chunk;
+        size_t threadCount = workers.size();
+        for (size_t i = 0; i < threadCount; ++i) {
+            size_t first = chunks * i / threadCount;
+            size_t last = chunks * (i + 1) / threadCount;
+            for (size_t j = first; j < last; ++j) {
+                size_t end = (j + 1) * chunk;
+                workers[i].chunks.push_back(std::make_pair(j * chunk, end < count ? end : count));
+            }
+        }
+
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < threadCount; ++i) {
+            threads.push_back(std::thread(&WorkStealingPool::work, this, i, std::cref(task)));
+        }
+        work(0, task);
+        for (size_t i = 0; i < threads.size(); ++i) {
+            threads[i].join();
+        }
+    }
+
+private:
+    typedef std::pair<size_t, size_t> Range;
+
+    struct Worker {
+        std::mutex lock;
+        std::deque<Range> chunks;
+    };
+
+    std::vector<Worker> workers;
+    std::atomic<unsigned long> steals{0};
+
+    bool pop(size_t index, Range &range) {
+        Worker &worker = workers[index];
+        std::lock_guard<std::mutex> guard(worker.lock);
+        if (worker.chunks.empty())
+            return false;
+        range = worker.chunks.back();
+        worker.chunks.pop_back();
+        return true;
+    }
+
+    bool steal(size_t thief, Range &range) {
+        for (size_t i = 1; i < workers.size(); ++i) {
+            Worker &victim = workers[(thief + i) % workers.size()];
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (!victim.chunks.empty()) {
+                range = victim.chunks.front();
+                victim.chunks.pop_front();
+                steals++;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void work(size_t index, const Task &task) {
+        // Chunks are only ever taken, so once every queue is seen empty the
+        // run is over.
+        Range range;
+        while (pop(index, range) || steal(index, range)) {
+            task(range.first, range.second);
+        }
+    }
+};
+
+#endif
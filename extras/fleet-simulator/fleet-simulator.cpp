@@ -0,0 +1,353 @@
+// Runs a fleet of LoRaModem nodes on a host, each against its own emulated
+// RN2483, and resolves their uplinks at a single gateway: how many arrive,
+// how many collide and how much airtime every node uses.
+//
+//   fleet-simulator [-n nodes] [-i interval] [-d hours] [-p payload] [-s sf|auto]
+//                   [-m margin] [-r radius] [-c channels] [-j threads] [-S seed] [-o file]
+//
+// See README.md.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "ABPCredentials.h"
+#include "BinaryPayload.h"
+#include "LoRaModem.h"
+
+#include "EmulatedModem.h"
+#include "Radio.h"
+#include "WorkStealingPool.h"
+
+// Below this much stronger than every overlapping uplink, an uplink is lost.
+static const double captureThreshold = 6;
+
+struct Settings {
+    unsigned int nodes = 1000;
+    double interval = 600; // Seconds between uplinks
+    double hours = 24;
+    unsigned int payload = 12;
+    unsigned int spreadingFactor = 0; // 0 picks the fastest that reaches the gateway
+    double margin = 5; // dB kept in hand when picking the spreading factor
+    double radius = 3000;
+    unsigned int channels = 3;
+    unsigned int threads = 0;
+    unsigned long seed = 1;
+    const char *path = 0;
+};
+
+struct Node {
+    Node(uint32_t id, double distance, unsigned int channelCount, uint32_t seed)
+        : id(id), distance(distance), power(receivedPower(distance)),
+          modem(id, channelCount, power, seed), lora(modem, debug), random(seed) {
+        for (unsigned int i = 0; i < 4; ++i) {
+            address[i] = id >> (24 - 8 * i);
+        }
+        memset(applicationKey, 0x2B, sizeof(applicationKey));
+        memset(networkKey, 0x7E, sizeof(networkKey));
+    }
+
+    uint32_t id;
+    double distance;
+    double power;
+    unsigned int spreadingFactor = 0;
+    bool joined = false;
+
+    EmulatedModem modem;
+    NullStream debug;
+    LoRaModem lora;
+    std::mt19937 random;
+
+    uint8_t address[4];
+    uint8_t applicationKey[16];
+    uint8_t networkKey[16];
+
+    unsigned long attempted = 0;
+    unsigned long delivered = 0;
+    unsigned long collided = 0;
+    unsigned long outOfRange = 0;
+    int64_t airtime = 0;
+};
+
+static double seconds(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+}
+
+// The sketch every node runs: join, then an uplink every interval, give or
+// take 10%, from a random start.
+static void runNode(const Settings &settings, Node &node) {
+    node.spreadingFactor = settings.spreadingFactor != 0
+        ? settings.spreadingFactor : lowestSpreadingFactor(node.power, settings.margin);
+
+    ABPCredentials credentials(node.address, node.applicationKey, node.networkKey);
+    if (!node.lora.init(credentials))
+        return;
+    node.joined = true;
+    node.lora.setSpreadingFactor(node.spreadingFactor);
+
+    std::uniform_real_distribution<double> start(0, settings.interval);
+    std::uniform_real_distribution<double> jitter(0.9, 1.1);
+    BinaryPayload payload(settings.payload);
+    double end = settings.hours * 3600;
+    for (double time = start(node.random); time < end; time += settings.interval * jitter(node.random)) {
+        node.modem.now = (int64_t)(time * 1e6);
+        payload.reset();
+        unsigned char *bytes = payload.reserve(settings.payload);
+        for (unsigned int i = 0; i < settings.payload; ++i) {
+            bytes[i] = node.random();
+        }
+        node.attempted++;
+        node.lora.send(payload, 1);
+    }
+}
+
+static bool sameSignal(const Transmission &a, const Transmission &b) {
+    return a.channel == b.channel && a.spreadingFactor == b.spreadingFactor;
+}
+
+static bool earlier(const Transmission &a, const Transmission &b) {
+    if (a.channel != b.channel) return a.channel < b.channel;
+    if (a.spreadingFactor != b.spreadingFactor) return a.spreadingFactor < b.spreadingFactor;
+    return a.start < b.start;
+}
+
+// Pure ALOHA at the gateway. Spreading factors are taken as orthogonal, so
+// only uplinks on the same channel and spreading factor can collide; an
+// uplink survives an overlap if it is captureThreshold dB stronger than
+// every uplink it overlaps.
+enum Outcome : uint8_t { delivered, collided, outOfRange };
+
+static Outcome resolve(const std::vector<Transmission> &all, size_t i, const int64_t *longest) {
+    const Transmission &own = all[i];
+    if (!own.reachable)
+        return outOfRange;
+
+    int64_t since = own.start - longest[own.spreadingFactor];
+    for (size_t j = i; j-- > 0 && sameSignal(all[j], own) && all[j].start >= since;) {
+        if (all[j].end > own.start && own.power - all[j].power < captureThreshold)
+            return collided;
+    }
+    for (size_t j = i + 1; j < all.size() && sameSignal(all[j], own) && all[j].start < own.end; ++j) {
+        if (own.power - all[j].power < captureThreshold)
+            return collided;
+    }
+    return delivered;
+}
+
+static void printPercent(const char *label, unsigned long count, unsigned long total) {
+    printf("%s%lu (%.2f%%)", label, count, total > 0 ? 100.0 * count / total : 0);
+}
+
+static int run(const Settings &settings) {
+    WorkStealingPool pool(settings.threads);
+
+    // Nodes are spread evenly over a disc around the gateway.
+    std::mt19937 random(settings.seed);
+    std::uniform_real_distribution<double> unit(0, 1);
+    std::vector<std::unique_ptr<Node> > nodes;
+    for (unsigned int i = 0; i < settings.nodes; ++i) {
+        double distance = settings.radius * sqrt(unit(random));
+        nodes.push_back(std::unique_ptr<Node>(new Node(i, distance, settings.channels, random())));
+    }
+
+    // Firmware: every node runs its sketch to the end, logging its uplinks.
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    pool.run(nodes.size(), 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            runNode(settings, *nodes[i]);
+        }
+    });
+    double firmware = seconds(started);
+
+    // Gateway: all uplinks in order of channel, spreading factor and start.
+    started = std::chrono::steady_clock::now();
+    std::vector<Transmission> all;
+    int64_t longest[13] = { 0 };
+    unsigned long blocked = 0;
+    unsigned long failed = 0;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        EmulatedModem &modem = nodes[i]->modem;
+        for (size_t j = 0; j < modem.transmissions.size(); ++j) {
+            const Transmission &transmission = modem.transmissions[j];
+            longest[transmission.spreadingFactor] =
+                std::max(longest[transmission.spreadingFactor], transmission.end - transmission.start);
+        }
+        all.insert(all.end(), modem.transmissions.begin(), modem.transmissions.end());
+        blocked += modem.blocked;
+        failed += nodes[i]->joined ? 0 : 1;
+    }
+    std::sort(all.begin(), all.end(), earlier);
+
+    std::vector<Outcome> outcomes(all.size());
+    pool.run(all.size(), 4096, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            outcomes[i] = resolve(all, i, longest);
+        }
+    });
+    double gateway = seconds(started);
+
+    // Totals per node and per spreading factor.
+    unsigned long attempted = 0;
+    unsigned long counts[3] = { 0 };
+    unsigned long sfNodes[13] = { 0 };
+    unsigned long sfUplinks[13] = { 0 };
+    unsigned long sfCounts[13][3] = { { 0 } };
+    int64_t sfAirtime[13] = { 0 };
+    for (size_t i = 0; i < all.size(); ++i) {
+        Node &node = *nodes[all[i].node];
+        int64_t duration = all[i].end - all[i].start;
+        node.airtime += duration;
+        switch (outcomes[i]) {
+            case delivered: node.delivered++; break;
+            case collided: node.collided++; break;
+            case outOfRange: node.outOfRange++; break;
+        }
+        counts[outcomes[i]]++;
+        sfUplinks[all[i].spreadingFactor]++;
+        sfCounts[all[i].spreadingFactor][outcomes[i]]++;
+        sfAirtime[all[i].spreadingFactor] += duration;
+    }
+    int64_t busiest = 0;
+    double totalAirtime = 0;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        attempted += nodes[i]->attempted;
+        sfNodes[nodes[i]->spreadingFactor]++;
+        busiest = std::max(busiest, nodes[i]->airtime);
+        totalAirtime += nodes[i]->airtime;
+    }
+
+    double hours = settings.hours;
+    printf("fleet        %u nodes within %.0f m, %u bytes every %.0f s for %.1f h on %u channels, ",
+           settings.nodes, settings.radius, settings.payload, settings.interval, hours, settings.channels);
+    if (settings.spreadingFactor != 0) {
+        printf("SF%u\n", settings.spreadingFactor);
+    } else {
+        printf("fastest SF with %.1f dB margin\n", settings.margin);
+    }
+    if (failed > 0) {
+        printf("join         %lu nodes failed to join\n", failed);
+    }
+    printf("uplinks      %lu attempted, ", attempted);
+    printPercent("", blocked, attempted);
+    printf(" blocked by duty cycle, ");
+    unsigned long refused = attempted - blocked - all.size();
+    if (refused > 0) {
+        printPercent("", refused, attempted);
+        printf(" refused by the modem or LoRaModem, ");
+    }
+    printf("%lu transmitted\n", (unsigned long)all.size());
+    printPercent("gateway      ", counts[delivered], attempted);
+    printPercent(" delivered of attempted, ", counts[collided], all.size());
+    printPercent(" collided and ", counts[outOfRange], all.size());
+    printf(" out of range of transmitted\n");
+    printf("airtime      %.2f s/h per node on average, %.2f s/h at most (%.3f%% duty cycle)\n",
+           totalAirtime / 1e6 / nodes.size() / hours, busiest / 1e6 / hours, busiest / 1e6 / (hours * 36));
+
+    printf("\n  SF  nodes   uplinks  delivered   collided  out of range  airtime ms\n");
+    for (unsigned int sf = 7; sf <= 12; ++sf) {
+        if (sfNodes[sf] == 0 && sfUplinks[sf] == 0)
+            continue;
+        unsigned long uplinks = sfUplinks[sf];
+        printf("  %2u %6lu %9lu %9.2f%% %9.2f%% %12.2f%% %11.1f\n", sf, sfNodes[sf], uplinks,
+               uplinks ? 100.0 * sfCounts[sf][delivered] / uplinks : 0,
+               uplinks ? 100.0 * sfCounts[sf][collided] / uplinks : 0,
+               uplinks ? 100.0 * sfCounts[sf][outOfRange] / uplinks : 0,
+               uplinks ? sfAirtime[sf] / 1e3 / uplinks : 0);
+    }
+
+    printf("\ntiming       firmware %.3f s (%.0f uplinks/s), gateway %.3f s, %u threads, %lu steals\n",
+           firmware, firmware > 0 ? attempted / firmware : 0, gateway, pool.getThreadCount(),
+           pool.getSteals());
+
+    if (settings.path) {
+        FILE *file = fopen(settings.path, "w");
+        if (!file) {
+            perror(settings.path);
+            return 1;
+        }
+        fprintf(file, "node,distance_m,power_dbm,sf,attempted,blocked,transmitted,delivered,collided,out_of_range,airtime_s\n");
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            const Node &node = *nodes[i];
+            fprintf(file, "%u,%.0f,%.1f,%u,%lu,%lu,%lu,%lu,%lu,%lu,%.3f\n", node.id, node.distance, node.power,
+                    node.spreadingFactor, node.attempted, node.modem.blocked,
+                    (unsigned long)node.modem.transmissions.size(), node.delivered, node.collided,
+                    node.outOfRange, node.airtime / 1e6);
+        }
+        fclose(file);
+    }
+    return 0;
+}
+
+static void usage() {
+    fprintf(stderr,
+        "usage: fleet-simulator [-n nodes] [-i interval] [-d hours] [-p payload] [-s sf|auto]\n"
+        "                       [-m margin] [-r radius] [-c channels] [-j threads] [-S seed] [-o file]\n"
+        "  -n  number of nodes (default 1000)\n"
+        "  -i  seconds between uplinks of a node, give or take 10%% (default 600)\n"
+        "  -d  simulated hours (default 24)\n"
+        "  -p  payload size in bytes (default 12)\n"
+        "  -s  spreading factor 7-12, or auto for the fastest that reaches the gateway (default)\n"
+        "  -m  link margin in dB for auto (default 5)\n"
+        "  -r  radius in meters of the disc the nodes are spread over (default 3000)\n"
+        "  -c  channels, 3 or 8 (default 3)\n"
+        "  -j  threads (default one per core)\n"
+        "  -S  random seed (default 1)\n"
+        "  -o  writes per-node results to this CSV file\n");
+}
+
+int main(int argc, char **argv) {
+    Settings settings;
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        if (!strcmp(arg, "-n") && i + 1 < argc) {
+            settings.nodes = strtoul(argv[++i], 0, 10);
+        } else if (!strcmp(arg, "-i") && i + 1 < argc) {
+            settings.interval = atof(argv[++i]);
+        } else if (!strcmp(arg, "-d") && i + 1 < argc) {
+            settings.hours = atof(argv[++i]);
+        } else if (!strcmp(arg, "-p") && i + 1 < argc) {
+            settings.payload = atoi(argv[++i]);
+        } else if (!strcmp(arg, "-s") && i + 1 < argc) {
+            ++i;
+            settings.spreadingFactor = strcmp(argv[i], "auto") ? atoi(argv[i]) : 0;
+            if (settings.spreadingFactor != 0 && (settings.spreadingFactor < 7 || settings.spreadingFactor > 12)) {
+                usage();
+                return 2;
+            }
+        } else if (!strcmp(arg, "-m") && i + 1 < argc) {
+            settings.margin = atof(argv[++i]);
+        } else if (!strcmp(arg, "-r") && i + 1 < argc) {
+            settings.radius = atof(argv[++i]);
+        } else if (!strcmp(arg, "-c") && i + 1 < argc) {
+            settings.channels = atoi(argv[++i]);
+        } else if (!strcmp(arg, "-j") && i + 1 < argc) {
+            settings.threads = atoi(argv[++i]);
+        } else if (!strcmp(arg, "-S") && i + 1 < argc) {
+            settings.seed = strtoul(argv[++i], 0, 10);
+        } else if (!strcmp(arg, "-o") && i + 1 < argc) {
+            settings.path = argv[++i];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (settings.nodes == 0 || settings.interval <= 0 || settings.hours <= 0 || settings.radius <= 0 ||
+            settings.payload == 0 || settings.payload > 222 ||
+            (settings.channels != 3 && settings.channels != 8)) {
+        usage();
+        return 2;
+    }
+    if (settings.threads == 0) {
+        settings.threads = std::thread::hardware_concurrency();
+    }
+
+    return run(settings);
+}
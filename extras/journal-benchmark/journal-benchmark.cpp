@@ -0,0 +1,320 @@
+// Measures UplinkJournal on a host: how many messages a storage holds, how
+// often each byte is written, and how fast a full journal replays.
+//
+//   journal-benchmark [-s storage] [-m message] [-c capacity] [-l laps] [-o file]
+//
+// See README.md.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "UplinkJournal.h"
+
+// Storage in a file, as it would be in EEPROM or flash, counting the writes
+// to every byte.
+class FileJournalStorage : public JournalStorage {
+public:
+    FileJournalStorage(FILE *file, unsigned long size) : writes(size), file(file) { }
+
+    virtual unsigned long getSize() { return writes.size(); }
+
+    virtual bool read(unsigned long address, unsigned char *bytes, unsigned int length) {
+        if (address + length > writes.size() || fseek(file, address, SEEK_SET) != 0)
+            return false;
+        return fread(bytes, 1, length, file) == length;
+    }
+
+    virtual bool write(unsigned long address, const unsigned char *bytes, unsigned int length) {
+        if (address + length > writes.size() || fseek(file, address, SEEK_SET) != 0)
+            return false;
+        for (unsigned int i = 0; i < length; ++i) {
+            writes[address + i]++;
+        }
+        return fwrite(bytes, 1, length, file) == length;
+    }
+
+    std::vector<unsigned long> writes;
+
+private:
+    FILE *file;
+};
+
+// The same in memory, for timing the journal rather than the file system.
+class CountingStorage : public JournalStorage {
+public:
+    CountingStorage(unsigned long size) : bytes(size, 0xFF), writes(size) { }
+
+    virtual unsigned long getSize() { return bytes.size(); }
+
+    virtual bool read(unsigned long address, unsigned char *out, unsigned int length) {
+        if (address + length > bytes.size())
+            return false;
+        memcpy(out, bytes.data() + address, length);
+        return true;
+    }
+
+    virtual bool write(unsigned long address, const unsigned char *in, unsigned int length) {
+        if (address + length > bytes.size())
+            return false;
+        for (unsigned int i = 0; i < length; ++i) {
+            writes[address + i]++;
+        }
+        memcpy(bytes.data() + address, in, length);
+        return true;
+    }
+
+    std::vector<unsigned char> bytes;
+    std::vector<unsigned long> writes;
+};
+
+struct Message {
+    unsigned char port;
+    uint32_t timestamp;
+    bool timed; // Only batched messages carry their timestamp
+    std::vector<unsigned char> bytes;
+};
+
+// Accepts every uplink, or none while down, and unpacks the batches so that
+// the replay can be checked against what was appended.
+class ReplayDevice : public Device<LoRaOptions> {
+public:
+    bool up = true;
+    unsigned long uplinks = 0;
+    unsigned long bytes = 0;
+    unsigned long malformed = 0;
+    std::vector<Message> received;
+
+    virtual bool send(Payload &payload) {
+        LoRaOptions options;
+        return send(payload, options);
+    }
+
+    virtual bool send(Payload *const *, unsigned int) {
+        return false;
+    }
+
+    virtual bool send(Payload &payload, LoRaOptions &options) {
+        if (!up) return false;
+        uplinks++;
+        bytes += payload.getSize();
+
+        const unsigned char *frame = payload.getBytes();
+        if (options.port != UplinkJournal::defaultBatchPort) {
+            Message message = { (unsigned char)options.port, 0, false,
+                                std::vector<unsigned char>(frame, frame + payload.getSize()) };
+            received.push_back(message);
+            return true;
+        }
+
+        UplinkBatchReader reader(frame, payload.getSize());
+        Message message = { 0, 0, true, std::vector<unsigned char>() };
+        const unsigned char *data;
+        unsigned int length;
+        while (reader.next(message.port, message.timestamp, data, length)) {
+            message.bytes.assign(data, data + length);
+            received.push_back(message);
+        }
+        if (!reader.isValid()) malformed++;
+        return true;
+    }
+};
+
+// Matches what the device received against the messages appended, oldest
+// first. The ones the journal dropped are skipped and counted.
+static bool check(std::deque<Message> &appended, ReplayDevice &device, unsigned long &skipped) {
+    for (unsigned int i = 0; i < device.received.size(); ++i) {
+        const Message &message = device.received[i];
+        while (!appended.empty() && (appended.front().port != message.port || appended.front().bytes != message.bytes
+                                     || (message.timed && appended.front().timestamp != message.timestamp))) {
+            appended.pop_front();
+            skipped++;
+        }
+        if (appended.empty())
+            return false;
+        appended.pop_front();
+    }
+    device.received.clear();
+    return device.malformed == 0;
+}
+
+// LoRaWAN header, port and MIC around every uplink.
+static const unsigned int framing = 13;
+
+struct Settings {
+    unsigned long storage = 4096; // EEPROM of the Sodaq Mbili's ATmega1284P
+    unsigned int message = 12;
+    unsigned int capacity = 51;
+    unsigned int laps = 100;
+    const char *path = 0;
+};
+
+static double seconds(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+}
+
+// A message on a random port below the batch port, a minute after the last.
+static void nextMessage(std::mt19937 &random, Message &message) {
+    message.port = 1 + random() % (UplinkJournal::defaultBatchPort - 1);
+    message.timestamp += 60;
+    for (unsigned int i = 0; i < message.bytes.size(); ++i) {
+        message.bytes[i] = random();
+    }
+}
+
+static int run(const Settings &settings, JournalStorage &storage, std::vector<unsigned long> &writes) {
+    UplinkJournal *journal = new UplinkJournal(storage, settings.capacity);
+    if (!journal->begin()) {
+        fprintf(stderr, "the storage is too small or cannot be written\n");
+        delete journal;
+        return 1;
+    }
+
+    std::mt19937 random(1);
+    Message message = { 0, 1700000000, true, std::vector<unsigned char>(settings.message) };
+    std::deque<Message> appended;
+
+    // Capacity: append while offline until the oldest message is dropped.
+    unsigned long held = 0;
+    while (journal->getDropped() == 0) {
+        nextMessage(random, message);
+        if (!journal->append(message.bytes.data(), message.bytes.size(), message.port, message.timestamp)) {
+            fprintf(stderr, "a message of %u bytes does not fit\n", settings.message);
+            delete journal;
+            return 1;
+        }
+        appended.push_back(message);
+        held = journal->getPending();
+    }
+    printf("storage      %lu bytes hold %lu messages of %u bytes: %.1f%% payload, %u bytes overhead each\n",
+           storage.getSize(), held, settings.message,
+           100.0 * held * settings.message / storage.getSize(), UplinkJournal::headerSize);
+
+    // Recovery after a reset.
+    unsigned long dropped = journal->getDropped();
+    delete journal;
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    journal = new UplinkJournal(storage, settings.capacity);
+    journal->begin();
+    double recovery = seconds(started);
+    printf("recovery     %u messages found in %.3f ms\n", journal->getPending(), recovery * 1000);
+
+    // Replay: drain the full journal in batches.
+    ReplayDevice device;
+    started = std::chrono::steady_clock::now();
+    unsigned int sent = journal->drain(device);
+    double replay = seconds(started);
+    printf("replay       %u messages in %lu uplinks instead of %u, %lu bytes on air instead of %lu, %.0f messages/s\n",
+           sent, device.uplinks, sent, device.bytes + device.uplinks * framing,
+           (unsigned long)sent * (settings.message + framing), replay > 0 ? sent / replay : 0);
+
+    // Wear: laps of appending while offline, then draining, with a reset
+    // now and then. Every message sent is checked against what was appended.
+    for (unsigned long i = 0; i < writes.size(); ++i) {
+        writes[i] = 0;
+    }
+    unsigned long skipped = 0;
+    unsigned long resets = 0;
+    bool matched = check(appended, device, skipped);
+    unsigned long count = 0;
+    unsigned long target = (unsigned long)settings.laps * held;
+    started = std::chrono::steady_clock::now();
+    while (count < target && matched) {
+        device.up = false;
+        unsigned int outage = 1 + random() % (2 * held);
+        unsigned int reset = random() % (4 * outage);
+        for (unsigned int i = 0; i < outage && count < target; ++i, ++count) {
+            if (i == reset) {
+                dropped += journal->getDropped();
+                delete journal;
+                journal = new UplinkJournal(storage, settings.capacity);
+                journal->begin();
+                resets++;
+            }
+            nextMessage(random, message);
+            journal->append(message.bytes.data(), message.bytes.size(), message.port, message.timestamp);
+            appended.push_back(message);
+        }
+        device.up = true;
+        journal->drain(device);
+        matched = check(appended, device, skipped);
+    }
+    double cycling = seconds(started);
+    dropped += journal->getDropped();
+    skipped += appended.size();
+    delete journal;
+
+    unsigned long most = 0;
+    unsigned long long total = 0;
+    for (unsigned long i = 0; i < writes.size(); ++i) {
+        if (writes[i] > most) most = writes[i];
+        total += writes[i];
+    }
+    printf("wear         %lu messages over %u laps: at most %lu writes to a byte, %.2f on average, %.1f bytes written per message\n",
+           count, settings.laps, most, (double)total / writes.size(), (double)total / count);
+    printf("append       %.0f messages/s, including drains\n", cycling > 0 ? count / cycling : 0);
+
+    if (!matched || skipped != dropped) {
+        fprintf(stderr, "the messages sent do not match the ones appended (%lu missing, %lu dropped)\n", skipped, dropped);
+        return 1;
+    }
+    printf("check        every message sent in order, with its port and timestamp, across %lu resets\n", resets);
+    return 0;
+}
+
+static void usage() {
+    fprintf(stderr,
+        "usage: journal-benchmark [-s storage] [-m message] [-c capacity] [-l laps] [-o file]\n"
+        "  -s  storage size in bytes (default 4096, at most 65535)\n"
+        "  -m  message size in bytes (default 12)\n"
+        "  -c  frame capacity, the largest uplink (default 51)\n"
+        "  -l  laps around the storage for the wear test (default 100)\n"
+        "  -o  keeps the journal in this file instead of in memory\n");
+}
+
+int main(int argc, char **argv) {
+    Settings settings;
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        if (!strcmp(arg, "-s") && i + 1 < argc) {
+            settings.storage = strtoul(argv[++i], 0, 10);
+        } else if (!strcmp(arg, "-m") && i + 1 < argc) {
+            settings.message = atoi(argv[++i]);
+        } else if (!strcmp(arg, "-c") && i + 1 < argc) {
+            settings.capacity = atoi(argv[++i]);
+        } else if (!strcmp(arg, "-l") && i + 1 < argc) {
+            settings.laps = atoi(argv[++i]);
+        } else if (!strcmp(arg, "-o") && i + 1 < argc) {
+            settings.path = argv[++i];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (settings.storage == 0 || settings.storage > 65535 || settings.capacity == 0) {
+        usage();
+        return 2;
+    }
+
+    if (settings.path) {
+        FILE *file = fopen(settings.path, "w+b");
+        if (!file) {
+            perror(settings.path);
+            return 1;
+        }
+        std::vector<unsigned char> erased(settings.storage, 0xFF);
+        fwrite(erased.data(), 1, erased.size(), file);
+        FileJournalStorage storage(file, settings.storage);
+        int result = run(settings, storage, storage.writes);
+        fclose(file);
+        return result;
+    }
+
+    CountingStorage storage(settings.storage);
+    return run(settings, storage, storage.writes);
+}
@@ -0,0 +1,539 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "Abcl.h"
+#include "Json.h"
+#include "ByteOrder.h"
+
+static const unsigned int maxStack = 32;
+
+// Just enough of a JSON parser for a conversion.
+
+struct JsonValue {
+    enum Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+    Type type = NUL;
+    bool boolean = false;
+    double number = 0;
+    std::string text;
+    std::vector<JsonValue> items;
+    std::vector<std::string> keys; // For objects, one per item
+};
+
+class JsonParser {
+public:
+    JsonParser(const char *text) : position(text) { }
+
+    bool parse(JsonValue &value, std::string &error) {
+        if (!parseValue(value, 0)) {
+            error = "invalid JSON";
+            return false;
+        }
+        skipSpace();
+        if (*position != 0) {
+            error = "invalid JSON";
+            return false;
+        }
+        return true;
+    }
+
+private:
+    const char *position;
+
+    void skipSpace() {
+        while (*position == ' ' || *position == '\t' || *position == '\r' || *position == '\n') ++position;
+    }
+
+    bool consume(const char *word) {
+        unsigned int length = strlen(word);
+        if (strncmp(position, word, length) != 0) return false;
+        position += length;
+        return true;
+    }
+
+    bool parseValue(JsonValue &value, unsigned int depth) {
+        if (depth > 32) return false;
+        skipSpace();
+
+        if (*position == '{' || *position == '[') {
+            bool isObject = *position++ == '{';
+            value.type = isObject ? JsonValue::OBJECT : JsonValue::ARRAY;
+            skipSpace();
+            if (*position == (isObject ? '}' : ']')) {
+                ++position;
+                return true;
+            }
+            for (;;) {
+                if (isObject) {
+                    skipSpace();
+                    std::string key;
+                    if (*position != '"' || !parseString(key)) return false;
+                    skipSpace();
+                    if (*position++ != ':') return false;
+                    value.keys.push_back(key);
+                }
+                value.items.push_back(JsonValue());
+                if (!parseValue(value.items.back(), depth + 1)) return false;
+                skipSpace();
+                if (*position == ',') {
+                    ++position;
+                } else if (*position == (isObject ? '}' : ']')) {
+                    ++position;
+                    return true;
+                } else {
+                    return false;
+                }
+            }
+        }
+
+        if (*position == '"') {
+            value.type = JsonValue::STRING;
+            return parseString(value.text);
+        }
+        if (consume("true")) {
+            value.type = JsonValue::BOOLEAN;
+            value.boolean = true;
+            return true;
+        }
+        if (consume("false")) {
+            value.type = JsonValue::BOOLEAN;
+            return true;
+        }
+        if (consume("null")) {
+            value.type = JsonValue::NUL;
+            return true;
+        }
+
+        char *end;
+        value.number = strtod(position, &end);
+        if (end == position) return false;
+        value.type = JsonValue::NUMBER;
+        position = end;
+        return true;
+    }
+
+    bool parseString(std::string &text) {
+        ++position;
+        for (;;) {
+            char c = *position++;
+            if (c == '"') return true;
+            if (c == 0) return false;
+            if (c != '\\') {
+                text += c;
+                continue;
+            }
+
+            c = *position++;
+            switch (c) {
+                case '"': case '\\': case '/': text += c; break;
+                case 'b': text += '\b'; break;
+                case 'f': text += '\f'; break;
+                case 'n': text += '\n'; break;
+                case 'r': text += '\r'; break;
+                case 't': text += '\t'; break;
+                case 'u': {
+                    unsigned int code = 0;
+                    for (int i = 0; i < 4; ++i) {
+                        char h = *position++;
+                        int digit;
+                        if (h >= '0' && h <= '9') digit = h - '0';
+                        else if (h >= 'a' && h <= 'f') digit = h - 'a' + 10;
+                        else if (h >= 'A' && h <= 'F') digit = h - 'A' + 10;
+                        else return false;
+                        code = (code << 4) | digit;
+                    }
+                    // UTF-8; surrogate pairs are not combined.
+                    if (code < 0x80) {
+                        text += (char)code;
+                    } else if (code < 0x800) {
+                        text += (char)(0xC0 | (code >> 6));
+                        text += (char)(0x80 | (code & 0x3F));
+                    } else {
+                        text += (char)(0xE0 | (code >> 12));
+                        text += (char)(0x80 | ((code >> 6) & 0x3F));
+                        text += (char)(0x80 | (code & 0x3F));
+                    }
+                    break;
+                }
+                default: return false;
+            }
+        }
+    }
+};
+
+static const JsonValue *member(const JsonValue &object, const char *key) {
+    for (unsigned int i = 0; i < object.keys.size(); ++i) {
+        if (object.keys[i] == key) return &object.items[i];
+    }
+    return 0;
+}
+
+// Calculations, compiled to postfix by recursive descent.
+
+class CalculationParser {
+public:
+    CalculationParser(const char *text, std::vector<AbclOp> &ops) : position(text), ops(ops) { }
+
+    bool parse() {
+        if (!parseSum(0)) return false;
+        skipSpace();
+        return *position == 0 && stack == 1;
+    }
+
+private:
+    const char *position;
+    std::vector<AbclOp> &ops;
+    unsigned int stack = 0;
+
+    void skipSpace() {
+        while (*position == ' ' || *position == '\t') ++position;
+    }
+
+    void emit(char op, double number = 0) {
+        AbclOp step = { op, number };
+        ops.push_back(step);
+        if (op == 'n' || op == 'v') {
+            ++stack;
+        } else {
+            --stack;
+        }
+    }
+
+    bool parseSum(unsigned int depth) {
+        if (!parseProduct(depth)) return false;
+        for (;;) {
+            skipSpace();
+            char op = *position;
+            if (op != '+' && op != '-') return true;
+            ++position;
+            if (!parseProduct(depth)) return false;
+            emit(op);
+        }
+    }
+
+    bool parseProduct(unsigned int depth) {
+        if (!parseFactor(depth)) return false;
+        for (;;) {
+            skipSpace();
+            char op = *position;
+            if (op != '*' && op != '/') return true;
+            ++position;
+            if (!parseFactor(depth)) return false;
+            emit(op);
+        }
+    }
+
+    bool parseFactor(unsigned int depth) {
+        if (depth > 8 || stack >= maxStack - 1) return false;
+        skipSpace();
+
+        if (*position == '(') {
+            ++position;
+            if (!parseSum(depth + 1)) return false;
+            skipSpace();
+            return *position++ == ')';
+        }
+        if (*position == '-') {
+            ++position;
+            emit('n', 0);
+            if (!parseFactor(depth + 1)) return false;
+            emit('-');
+            return true;
+        }
+        if (strncmp(position, "val", 3) == 0) {
+            position += 3;
+            emit('v');
+            return true;
+        }
+
+        char *end;
+        double number = strtod(position, &end);
+        if (end == position) return false;
+        position = end;
+        emit('n', number);
+        return true;
+    }
+};
+
+double AbclConversion::calculate(const std::vector<AbclOp> &calculation, double val) {
+    if (calculation.empty())
+        return val;
+
+    double stack[maxStack];
+    unsigned int top = 0;
+    for (unsigned int i = 0; i < calculation.size(); ++i) {
+        const AbclOp &step = calculation[i];
+        switch (step.op) {
+            case 'n': stack[top++] = step.number; break;
+            case 'v': stack[top++] = val; break;
+            case '+': --top; stack[top - 1] += stack[top]; break;
+            case '-': --top; stack[top - 1] -= stack[top]; break;
+            case '*': --top; stack[top - 1] *= stack[top]; break;
+            case '/': --top; stack[top - 1] /= stack[top]; break;
+        }
+    }
+    return stack[0];
+}
+
+// Compiling
+
+static bool readCount(const JsonValue &value, const char *key, unsigned int max, unsigned int &count, std::string &error) {
+    const JsonValue *item = member(value, key);
+    if (!item) return false;
+    if (item->type != JsonValue::NUMBER || item->number < 0 || item->number > max || item->number != (unsigned int)item->number) {
+        error = std::string("\"") + key + "\" is not a valid count";
+        return false;
+    }
+    count = item->number;
+    return true;
+}
+
+static bool compileField(const JsonValue &entry, AbclField &field, std::string &error) {
+    static const char *const known[] = { "byte", "bytelength", "bit", "bitlength", "type", "signed", "calculation" };
+
+    const JsonValue *asset = member(entry, "asset");
+    const JsonValue *value = member(entry, "value");
+    if (entry.type != JsonValue::OBJECT || !asset || asset->type != JsonValue::STRING || !value || value->type != JsonValue::OBJECT) {
+        error = "every entry needs an \"asset\" and a \"value\" object";
+        return false;
+    }
+    field.asset = asset->text;
+    error = "\"" + field.asset + "\": ";
+
+    for (unsigned int i = 0; i < value->keys.size(); ++i) {
+        bool found = false;
+        for (unsigned int k = 0; k < sizeof(known) / sizeof(known[0]); ++k) {
+            if (value->keys[i] == known[k]) found = true;
+        }
+        if (!found) {
+            error += "\"" + value->keys[i] + "\" is not supported";
+            return false;
+        }
+    }
+
+    const JsonValue *type = member(*value, "type");
+    const JsonValue *isSigned = member(*value, "signed");
+    const JsonValue *calculation = member(*value, "calculation");
+    std::string reason;
+
+    if (!readCount(*value, "byte", 65535, field.byte, reason)) {
+        error += reason.empty() ? "\"byte\" is missing" : reason;
+        return false;
+    }
+    field.packed = member(*value, "bitlength") != 0;
+    if (field.packed) {
+        field.bit = 0;
+        if (!readCount(*value, "bitlength", 32, field.length, reason) || field.length == 0
+                || (member(*value, "bit") && !readCount(*value, "bit", 7, field.bit, reason))
+                || member(*value, "bytelength")) {
+            error += "\"bitlength\" takes 1 to 32 bits, \"bit\" 0 to 7, and no \"bytelength\"";
+            return false;
+        }
+    } else if (!readCount(*value, "bytelength", 65535, field.length, reason) || field.length == 0 || member(*value, "bit")) {
+        error += "needs a \"bytelength\" of at least 1, or a \"bitlength\"";
+        return false;
+    }
+
+    if (!type || type->type != JsonValue::STRING) {
+        error += "\"type\" is missing";
+        return false;
+    }
+    if (isSigned && isSigned->type != JsonValue::BOOLEAN) {
+        error += "\"signed\" must be true or false";
+        return false;
+    }
+    bool signedInteger = isSigned && isSigned->boolean;
+
+    if (type->text == "number" || type->text == "integer") {
+        if (!field.packed && type->text == "number" && field.length == 4) {
+            field.kind = ABCL_FLOAT;
+        } else if (!field.packed && type->text == "number" && field.length == 8) {
+            field.kind = ABCL_DOUBLE;
+        } else if (!field.packed && field.length > 8) {
+            error += "integers take at most 8 bytes";
+            return false;
+        } else {
+            field.kind = signedInteger ? ABCL_SIGNED : ABCL_UNSIGNED;
+        }
+    } else if (type->text == "boolean") {
+        field.kind = ABCL_BOOLEAN;
+    } else if (type->text == "string") {
+        if (field.packed) {
+            error += "strings take a \"bytelength\"";
+            return false;
+        }
+        field.kind = ABCL_STRING;
+    } else {
+        error += "type \"" + type->text + "\" is not supported";
+        return false;
+    }
+
+    if (calculation) {
+        if (calculation->type != JsonValue::STRING || field.kind == ABCL_BOOLEAN || field.kind == ABCL_STRING) {
+            error += "only numbers and integers take a \"calculation\"";
+            return false;
+        }
+        CalculationParser parser(calculation->text.c_str(), field.calculation);
+        if (!parser.parse()) {
+            error += "cannot read calculation \"" + calculation->text + "\"";
+            return false;
+        }
+    }
+
+    error.clear();
+    return true;
+}
+
+bool AbclConversion::compile(const char *json, std::string &error) {
+    fields.clear();
+    keys.clear();
+    frameSize = 0;
+
+    JsonValue root;
+    JsonParser parser(json);
+    if (!parser.parse(root, error))
+        return false;
+
+    const JsonValue *sense = root.type == JsonValue::OBJECT ? member(root, "sense") : 0;
+    if (!sense || sense->type != JsonValue::ARRAY) {
+        error = "expected an object with a \"sense\" array";
+        return false;
+    }
+
+    for (unsigned int i = 0; i < sense->items.size(); ++i) {
+        AbclField field;
+        if (!compileField(sense->items[i], field, error)) {
+            fields.clear();
+            return false;
+        }
+
+        unsigned int end = field.packed ? (field.byte * 8 + field.bit + field.length + 7) / 8 : field.byte + field.length;
+        if (end > frameSize) frameSize = end;
+
+        std::string key;
+        appendString(key, field.asset.data(), field.asset.size());
+        keys.push_back(key + ':');
+        fields.push_back(field);
+    }
+    return true;
+}
+
+unsigned int AbclConversion::getFieldCount() const {
+    return fields.size();
+}
+
+const AbclField &AbclConversion::getField(unsigned int index) const {
+    return fields[index];
+}
+
+unsigned int AbclConversion::getFrameSize() const {
+    return frameSize;
+}
+
+// Decoding
+
+bool AbclConversion::read(const unsigned char *frame, unsigned int size, AbclValue *values) const {
+    if (size < frameSize)
+        return false;
+
+    for (unsigned int i = 0; i < fields.size(); ++i) {
+        const AbclField &field = fields[i];
+        const unsigned char *in = frame + field.byte;
+        AbclValue &value = values[i];
+        value.calculated = false;
+        value.text = 0;
+        value.length = 0;
+
+        uint64_t bits = 0;
+        unsigned int width = 0;
+        if (field.packed) {
+            bits = loadBits(in, field.bit, field.length);
+            width = field.length;
+        } else if (field.kind == ABCL_FLOAT) {
+            value.number = loadBigEndian<float>(in);
+        } else if (field.kind == ABCL_DOUBLE) {
+            value.number = loadBigEndian<double>(in);
+        } else if (field.kind == ABCL_STRING) {
+            const void *zero = memchr(in, 0, field.length);
+            value.text = in;
+            value.length = zero ? (const unsigned char *)zero - in : field.length;
+            continue;
+        } else {
+            // Booleans may be longer than 8 bytes; any bit set is true.
+            for (unsigned int b = 0; b < field.length; ++b) {
+                bits = field.kind == ABCL_BOOLEAN ? bits | in[b] : (bits << 8) | in[b];
+            }
+            width = field.length * 8;
+        }
+
+        switch (field.kind) {
+            case ABCL_BOOLEAN:
+                value.boolean = bits != 0;
+                continue;
+            case ABCL_SIGNED:
+                if (width < 64 && (bits >> (width - 1)) & 1) {
+                    bits |= ~0ULL << width;
+                }
+                value.integer = bits;
+                value.number = (double)(int64_t)bits;
+                break;
+            case ABCL_UNSIGNED:
+                value.integer = bits;
+                value.number = (double)bits;
+                break;
+            default:
+                break;
+        }
+
+        if (!field.calculation.empty()) {
+            value.number = calculate(field.calculation, value.number);
+            value.calculated = true;
+        }
+    }
+    return true;
+}
+
+void AbclConversion::write(const AbclValue *values, std::string &out) const {
+    out += '{';
+    for (unsigned int i = 0; i < fields.size(); ++i) {
+        if (i > 0) out += ',';
+        out += keys[i];
+
+        const AbclValue &value = values[i];
+        switch (fields[i].kind) {
+            case ABCL_BOOLEAN:
+                out += value.boolean ? "true" : "false";
+                break;
+            case ABCL_STRING:
+                appendString(out, (const char *)value.text, value.length);
+                break;
+            case ABCL_UNSIGNED:
+            case ABCL_SIGNED:
+                if (!value.calculated) {
+                    bool negative = fields[i].kind == ABCL_SIGNED && (int64_t)value.integer < 0;
+                    appendInteger(out, negative ? ~value.integer : value.integer, negative);
+                    break;
+                }
+                // Fall through
+            default:
+                appendNumber(out, value.number);
+                break;
+        }
+    }
+    out += '}';
+}
+
+bool AbclConversion::decode(const unsigned char *frame, unsigned int size, std::string &out) const {
+    AbclValue stackValues[16];
+    std::vector<AbclValue> heapValues;
+    AbclValue *values = stackValues;
+    if (fields.size() > 16) {
+        heapValues.resize(fields.size());
+        values = heapValues.data();
+    }
+
+    if (!read(frame, size, values))
+        return false;
+    write(values, out);
+    return true;
+}
@@ -0,0 +1,88 @@
+#ifndef ABCL_H_
+#define ABCL_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+// Applies an ABCL conversion (the "sense" JSON pasted into Maker for binary
+// payloads) to frames. The JSON is compiled once into a flat list of fields;
+// decoding a frame then only reads bytes, without looking up anything.
+//
+//   { "sense": [ { "asset": "random",
+//                  "value": { "byte": 0, "bytelength": 4, "type": "number" } }, ... ] }
+//
+// A value takes either "byte" and "bytelength", or "byte", "bit" (counted
+// from the most significant bit of "byte") and "bitlength" for fields packed
+// with BinaryPayload::addBits. Types:
+//
+//   "number"   4 bytes: float, 8 bytes: double, otherwise an integer
+//   "integer"  unsigned, or signed with "signed": true
+//   "boolean"  true when any bit is set
+//   "string"   up to bytelength characters, ending at the first zero byte
+//
+// Numbers and integers take an optional "calculation" on val, e.g.
+// "(val - 200) / 100", with + - * / and parentheses. Everything is
+// big-endian, as written by BinaryPayload.
+
+enum AbclKind { ABCL_FLOAT, ABCL_DOUBLE, ABCL_UNSIGNED, ABCL_SIGNED, ABCL_BOOLEAN, ABCL_STRING };
+
+// One step of a calculation in postfix order: 'n' pushes number, 'v' pushes
+// val, and + - * / combine the top two.
+struct AbclOp {
+    char op;
+    double number;
+};
+
+struct AbclField {
+    std::string asset;
+    AbclKind kind;
+    unsigned int byte;
+    unsigned int length;  // Bytes, or bits when packed
+    unsigned int bit;
+    bool packed;
+    std::vector<AbclOp> calculation; // Empty when there is none
+};
+
+// A decoded value: integers stay exact unless a calculation applies, text
+// points into the frame.
+struct AbclValue {
+    bool calculated;
+    bool boolean;
+    uint64_t integer; // Two's complement for ABCL_SIGNED
+    double number;
+    const unsigned char *text;
+    unsigned int length;
+};
+
+class AbclConversion {
+public:
+    // Returns false, with a message in error, for JSON that is not a valid
+    // conversion or uses ABCL features that are not supported here.
+    bool compile(const char *json, std::string &error);
+
+    unsigned int getFieldCount() const;
+    const AbclField &getField(unsigned int index) const;
+
+    // Bytes a frame needs to hold every field.
+    unsigned int getFrameSize() const;
+
+    // Fills one value per field. Returns false if the frame is too short.
+    bool read(const unsigned char *frame, unsigned int size, AbclValue *values) const;
+
+    // Appends the values as a JSON object, keyed by asset.
+    void write(const AbclValue *values, std::string &out) const;
+
+    bool decode(const unsigned char *frame, unsigned int size, std::string &out) const;
+
+    // Applies a compiled calculation; returns val if there is none.
+    static double calculate(const std::vector<AbclOp> &calculation, double val);
+
+private:
+    std::vector<AbclField> fields;
+    std::vector<std::string> keys; // Asset names as JSON keys, with the colon
+    unsigned int frameSize = 0;
+};
+
+#endif
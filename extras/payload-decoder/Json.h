@@ -0,0 +1,64 @@
+#ifndef JSON_H_
+#define JSON_H_
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+
+#include <string>
+
+// Appending JSON values to a line of output.
+
+inline void appendHex(std::string &out, const unsigned char *data, unsigned int size) {
+    static const char digits[] = "0123456789abcdef";
+    for (unsigned int i = 0; i < size; ++i) {
+        out += digits[data[i] >> 4];
+        out += digits[data[i] & 15];
+    }
+}
+
+inline void appendString(std::string &out, const char *text, unsigned int length) {
+    out += '"';
+    for (unsigned int i = 0; i < length; ++i) {
+        unsigned char c = text[i];
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (c < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+inline void appendString(std::string &out, const char *text) {
+    appendString(out, text, strlen(text));
+}
+
+inline void appendNumber(std::string &out, double value) {
+    if (isnan(value) || isinf(value)) {
+        out += "null";
+        return;
+    }
+    char text[32];
+    snprintf(text, sizeof(text), "%.9g", value);
+    out += text;
+}
+
+inline void appendInteger(std::string &out, uint64_t value, bool negative) {
+    if (negative && value == 0xFFFFFFFFFFFFFFFFULL) {
+        out += "-18446744073709551616";
+        return;
+    }
+    // A negative CBOR integer is -1 - value.
+    char text[32];
+    snprintf(text, sizeof(text), negative ? "-%llu" : "%llu", (unsigned long long)value + (negative ? 1 : 0));
+    out += text;
+}
+
+#endif
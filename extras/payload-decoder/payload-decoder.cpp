@@ -0,0 +1,745 @@
+// Decodes captured uplinks on a host, one JSON line per frame.
+//
+//   payload-decoder [-f format] [-c conversion] [-x | -b] [-z] [-j threads] [-n] [file ...]
+//
+// Reads stdin when no file is given. See README.md for the formats.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <math.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GeoLocation.h"
+#include "TrackPayload.h"
+#include "LppPayload.h"
+#include "TimeSeriesPayload.h"
+#include "CompressedPayload.h"
+#include "UplinkJournal.h"
+#include "Library-Arduino-Cbor/CborCursor.h"
+
+#include "Abcl.h"
+#include "Json.h"
+
+static const unsigned int batchFrames = 4096;
+static const unsigned int chunkSize = 1 << 20;
+static const unsigned int maxFrameSize = 65535;
+static const unsigned int maxExpandedSize = 65536;
+
+static void appendLocation(std::string &out, GeoLocation location) {
+    out += "{\"latitude\":";
+    appendNumber(out, location.latitude);
+    out += ",\"longitude\":";
+    appendNumber(out, location.longitude);
+    if (location.hasAltitude()) {
+        out += ",\"altitude\":";
+        appendNumber(out, location.altitude);
+    }
+    out += '}';
+}
+
+// CBOR
+
+static bool appendCbor(CborCursor &cursor, std::string &out, unsigned int depth);
+
+static bool appendCborItem(CborCursor &cursor, const CborToken &token, std::string &out, unsigned int depth) {
+    if (depth >= CborCursor::maxDepth)
+        return false;
+
+    CborToken item = token;
+    switch (item.type) {
+        case CBOR_UNSIGNED:
+        case CBOR_NEGATIVE:
+            appendInteger(out, item.value, item.type == CBOR_NEGATIVE);
+            return true;
+
+        case CBOR_BYTES:
+            out += '"';
+            appendHex(out, item.data, item.length);
+            out += '"';
+            return true;
+
+        case CBOR_STRING:
+            appendString(out, (const char *)item.data, item.length);
+            return true;
+
+        case CBOR_FLOAT:
+            appendNumber(out, item.number);
+            return true;
+
+        case CBOR_SIMPLE:
+            if (item.isBool()) {
+                out += item.asBool() ? "true" : "false";
+            } else {
+                out += "null";
+            }
+            return true;
+
+        case CBOR_ARRAY:
+        case CBOR_MAP: {
+            bool isMap = item.type == CBOR_MAP;
+            out += isMap ? '{' : '[';
+            for (uint64_t i = 0; item.indefinite || i < item.value; ++i) {
+                CborToken element;
+                if (!cursor.next(element))
+                    return false;
+                if (element.type == CBOR_BREAK) {
+                    if (!item.indefinite) return false;
+                    break;
+                }
+                if (i > 0) out += ',';
+
+                if (isMap) {
+                    // JSON keys are strings; anything else is written as one.
+                    if (element.type == CBOR_STRING) {
+                        appendString(out, (const char *)element.data, element.length);
+                    } else {
+                        std::string key;
+                        if (!appendCborItem(cursor, element, key, depth + 1))
+                            return false;
+                        appendString(out, key.data(), key.size());
+                    }
+                    out += ':';
+                    if (!appendCbor(cursor, out, depth + 1))
+                        return false;
+                } else if (!appendCborItem(cursor, element, out, depth + 1)) {
+                    return false;
+                }
+            }
+            out += isMap ? '}' : ']';
+            return true;
+        }
+
+        case CBOR_TAG: {
+            CborToken tagged;
+            if (!cursor.next(tagged) || tagged.type == CBOR_BREAK)
+                return false;
+
+            if (item.value == 120 && tagged.type == CBOR_ARRAY && !tagged.indefinite && tagged.value >= 1 && tagged.value <= 3) {
+                // IoT data point: [assets, timestamp, location]; null where absent.
+                static const char *const names[] = { "assets", "timestamp", "location" };
+                out += '{';
+                bool first = true;
+                for (unsigned int i = 0; i < tagged.value; ++i) {
+                    CborToken element;
+                    if (!cursor.next(element) || element.type == CBOR_BREAK)
+                        return false;
+                    if (element.isNull()) continue;
+                    if (!first) out += ',';
+                    first = false;
+                    appendString(out, names[i]);
+                    out += ':';
+                    if (!appendCborItem(cursor, element, out, depth + 1))
+                        return false;
+                }
+                out += '}';
+                return true;
+            }
+
+            if (item.value == 103 && tagged.type == CBOR_ARRAY && !tagged.indefinite && (tagged.value == 2 || tagged.value == 3)) {
+                double coordinates[3] = { 0, 0, 0 };
+                for (unsigned int i = 0; i < tagged.value; ++i) {
+                    CborToken element;
+                    if (!cursor.next(element) || (element.type != CBOR_FLOAT && !element.isInteger()))
+                        return false;
+                    coordinates[i] = element.asNumber();
+                }
+                GeoLocation location = tagged.value == 3
+                    ? GeoLocation(coordinates[0], coordinates[1], coordinates[2])
+                    : GeoLocation(coordinates[0], coordinates[1]);
+                appendLocation(out, location);
+                return true;
+            }
+
+            if (item.value == GeoLocation::compactTag && tagged.type == CBOR_BYTES) {
+                GeoLocation location;
+                if (!GeoLocation::fromCompact(tagged.data, tagged.length, location))
+                    return false;
+                appendLocation(out, location);
+                return true;
+            }
+
+            // Tag 1 (unix time) and unknown tags: just the tagged item.
+            return appendCborItem(cursor, tagged, out, depth + 1);
+        }
+
+        case CBOR_BREAK:
+            return false;
+    }
+    return false;
+}
+
+static bool appendCbor(CborCursor &cursor, std::string &out, unsigned int depth) {
+    CborToken token;
+    if (!cursor.next(token))
+        return false;
+    return appendCborItem(cursor, token, out, depth);
+}
+
+static bool decodeCbor(const unsigned char *data, unsigned int size, std::string &out) {
+    CborCursor cursor(data, size);
+    return appendCbor(cursor, out, 0) && cursor.isValid() && cursor.atEnd();
+}
+
+// Other formats
+
+static bool decodeLpp(const unsigned char *data, unsigned int size, std::string &out) {
+    LppReader reader(data, size);
+    uint8_t channel, type;
+    float values[3];
+    unsigned int count;
+
+    out += '[';
+    for (bool first = true; reader.next(channel, type, values, count); first = false) {
+        if (!first) out += ',';
+        char text[48];
+        snprintf(text, sizeof(text), "{\"channel\":%u,\"type\":%u,\"values\":[", channel, type);
+        out += text;
+        for (unsigned int i = 0; i < count; ++i) {
+            if (i > 0) out += ',';
+            appendNumber(out, values[i]);
+        }
+        out += "]}";
+    }
+    out += ']';
+    return reader.isValid();
+}
+
+static bool decodeTrack(const unsigned char *data, unsigned int size, std::string &out) {
+    TrackReader reader(data, size);
+    GeoLocation location;
+    uint32_t timestamp;
+
+    out += '[';
+    for (bool first = true; reader.next(location, timestamp); first = false) {
+        if (!first) out += ',';
+        out += "{\"timestamp\":";
+        appendInteger(out, timestamp, false);
+        out += ",\"location\":";
+        appendLocation(out, location);
+        out += '}';
+    }
+    out += ']';
+    return reader.isValid();
+}
+
+static bool decodeTimeSeries(const unsigned char *data, unsigned int size, std::string &out) {
+    TimeSeriesReader reader(data, size);
+    const char *name;
+    unsigned int nameLength;
+    float value;
+    uint32_t timestamp;
+
+    out += '[';
+    for (bool first = true; reader.next(name, nameLength, value, timestamp); first = false) {
+        if (!first) out += ',';
+        out += "{\"asset\":";
+        appendString(out, name, nameLength);
+        out += ",\"timestamp\":";
+        appendInteger(out, timestamp, false);
+        out += ",\"value\":";
+        appendNumber(out, value);
+        out += '}';
+    }
+    out += ']';
+    return reader.isValid();
+}
+
+static bool decodeBatch(const unsigned char *data, unsigned int size, std::string &out) {
+    UplinkBatchReader reader(data, size);
+    unsigned char port;
+    uint32_t timestamp;
+    const unsigned char *message;
+    unsigned int length;
+
+    out += '[';
+    for (bool first = true; reader.next(port, timestamp, message, length); first = false) {
+        if (!first) out += ',';
+        out += "{\"port\":";
+        appendInteger(out, port, false);
+        out += ",\"timestamp\":";
+        appendInteger(out, timestamp, false);
+        out += ",\"hex\":\"";
+        appendHex(out, message, length);
+        out += "\"}";
+    }
+    out += ']';
+    return reader.isValid();
+}
+
+static bool decodeRaw(const unsigned char *data, unsigned int size, std::string &out) {
+    out += '"';
+    appendHex(out, data, size);
+    out += '"';
+    return true;
+}
+
+// Binary payloads, as described by the conversion given with -c.
+static AbclConversion conversion;
+
+static bool decodeAbcl(const unsigned char *data, unsigned int size, std::string &out) {
+    return conversion.decode(data, size, out);
+}
+
+typedef bool (*Decoder)(const unsigned char *data, unsigned int size, std::string &out);
+
+struct Format {
+    const char *name;
+    Decoder decode;
+};
+
+static const Format formats[] = {
+    { "cbor", decodeCbor },
+    { "lpp", decodeLpp },
+    { "track", decodeTrack },
+    { "timeseries", decodeTimeSeries },
+    { "batch", decodeBatch },
+    { "raw", decodeRaw },
+    { "abcl", decodeAbcl },
+};
+
+// Input
+
+struct Settings {
+    Decoder decode = decodeCbor;
+    bool binary = false;
+    bool compressed = false;
+    bool discard = false;
+    unsigned int threads = 0;
+};
+
+// A run of frames, read as is: hex lines or binary frames. Workers decode a
+// batch into its output; batches are written in the order they were read.
+struct Batch {
+    uint64_t sequence;
+    uint64_t firstFrame;
+    std::vector<unsigned char> data;
+    std::vector<unsigned int> offsets; // Frame i is [offsets[i], offsets[i + 1])
+    std::string output;
+    unsigned long errors = 0;
+};
+
+class FrameReader {
+public:
+    FrameReader(bool binary) : binary(binary), buffer(chunkSize + 1) { }
+
+    // Fills the batch from the files in turn; returns false once all input
+    // is consumed.
+    bool fill(std::vector<FILE *> &files, Batch &batch) {
+        batch.data.clear();
+        batch.offsets.assign(1, 0);
+
+        while (batch.offsets.size() <= batchFrames) {
+            if (nextFrame(batch.data)) {
+                batch.offsets.push_back(batch.data.size());
+            } else if (current >= files.size()) {
+                break;
+            } else if (!refill(files[current])) {
+                ++current;
+            }
+        }
+        return batch.offsets.size() > 1;
+    }
+
+    unsigned long getSkipped() {
+        return skipped;
+    }
+
+private:
+    bool binary;
+    std::vector<unsigned char> buffer;
+    unsigned int start = 0;
+    unsigned int end = 0;
+    unsigned int current = 0;
+    bool discarding = false;
+    unsigned long skipped = 0;
+
+    // Moves what is left to the front and reads more behind it. Returns
+    // false at the end of the file, once everything in it has been used.
+    bool refill(FILE *file) {
+        memmove(buffer.data(), buffer.data() + start, end - start);
+        end -= start;
+        start = 0;
+
+        if (end == chunkSize) {
+            // A line longer than the buffer; not a frame.
+            ++skipped;
+            end = 0;
+            discarding = true;
+        }
+
+        size_t count = fread(buffer.data() + end, 1, chunkSize - end, file);
+        end += count;
+        if (count > 0)
+            return true;
+
+        if (end == 0)
+            return false;
+        if (!binary) {
+            // The last line has no newline; the spare byte is for this one.
+            buffer[end++] = '\n';
+            return true;
+        }
+        ++skipped; // Truncated frame
+        end = 0;
+        return false;
+    }
+
+    // Copies the next whole frame out of the buffer, if there is one.
+    bool nextFrame(std::vector<unsigned char> &out) {
+        if (binary) {
+            if (end - start < 2) return false;
+            unsigned int length = (buffer[start] << 8) | buffer[start + 1];
+            if (end - start < 2 + length) return false;
+            out.insert(out.end(), buffer.begin() + start + 2, buffer.begin() + start + 2 + length);
+            start += 2 + length;
+            return true;
+        }
+
+        for (;;) {
+            unsigned char *line = buffer.data() + start;
+            unsigned char *newline = (unsigned char *)memchr(line, '\n', end - start);
+            if (!newline) return false;
+            start = newline + 1 - buffer.data();
+
+            if (discarding) {
+                discarding = false;
+                continue;
+            }
+
+            int result = parseHex(line, newline, out);
+            if (result > 0) return true;
+            if (result < 0) ++skipped;
+        }
+    }
+
+    // Hex digits; whitespace, colons and a "0x" prefix are ignored. Returns
+    // 1 for a frame, 0 for an empty line or # comment and -1 for anything
+    // else, which leaves out as it was.
+    static int parseHex(const unsigned char *line, const unsigned char *lineEnd, std::vector<unsigned char> &out) {
+        unsigned int size = out.size();
+        int high = -1;
+
+        for (const unsigned char *c = line; c < lineEnd; ++c) {
+            int digit;
+            if (*c >= '0' && *c <= '9') {
+                digit = *c - '0';
+            } else if (*c >= 'a' && *c <= 'f') {
+                digit = *c - 'a' + 10;
+            } else if (*c >= 'A' && *c <= 'F') {
+                digit = *c - 'A' + 10;
+            } else if (*c == ' ' || *c == '\t' || *c == '\r' || *c == ':') {
+                continue;
+            } else if (*c == '#' && high < 0 && out.size() == size) {
+                break;
+            } else if ((*c == 'x' || *c == 'X') && high == 0 && out.size() == size) {
+                high = -1;
+                continue;
+            } else {
+                high = -2;
+                break;
+            }
+
+            if (high < 0) {
+                high = digit;
+            } else {
+                out.push_back((high << 4) | digit);
+                high = -1;
+            }
+        }
+
+        if (high != -1 || out.size() - size > maxFrameSize) {
+            out.resize(size);
+            return -1;
+        }
+        return out.size() > size ? 1 : 0;
+    }
+};
+
+// Decoding
+
+static void decodeBatch(const Settings &settings, Batch &batch, std::vector<unsigned char> &expanded) {
+    batch.output.clear();
+    batch.errors = 0;
+
+    for (unsigned int i = 0; i + 1 < batch.offsets.size(); ++i) {
+        const unsigned char *data = batch.data.data() + batch.offsets[i];
+        unsigned int size = batch.offsets[i + 1] - batch.offsets[i];
+        unsigned int mark = batch.output.size();
+
+        char prefix[48];
+        snprintf(prefix, sizeof(prefix), "{\"frame\":%llu,\"size\":%u,", (unsigned long long)(batch.firstFrame + i), size);
+        batch.output += prefix;
+
+        bool valid = true;
+        if (settings.compressed) {
+            size = CompressedPayload::decode(data, size, expanded.data(), expanded.size());
+            data = expanded.data();
+            valid = size > 0;
+        }
+
+        if (valid) {
+            batch.output += "\"data\":";
+            valid = settings.decode(data, size, batch.output);
+        }
+
+        if (!valid) {
+            batch.output.resize(mark);
+            batch.output += prefix;
+            batch.output += "\"error\":\"malformed\",\"hex\":\"";
+            appendHex(batch.output, batch.data.data() + batch.offsets[i], batch.offsets[i + 1] - batch.offsets[i]);
+            batch.output += '"';
+            ++batch.errors;
+        }
+        batch.output += "}\n";
+    }
+}
+
+// Reader -> workers -> writer. The reader stops when too many batches are in
+// flight, so memory stays bounded however long the input is.
+class Pipeline {
+public:
+    Pipeline(const Settings &settings, std::vector<FILE *> &files) : settings(settings), files(files), reader(settings.binary) { }
+
+    void run(unsigned int threads) {
+        std::vector<std::thread> workers;
+        for (unsigned int i = 0; i < threads; ++i) {
+            workers.push_back(std::thread(&Pipeline::work, this));
+        }
+        std::thread writer(&Pipeline::write, this);
+
+        read(threads * 4);
+
+        for (unsigned int i = 0; i < workers.size(); ++i) {
+            workers[i].join();
+        }
+        writer.join();
+    }
+
+    uint64_t frames = 0;
+    unsigned long errors = 0;
+
+    unsigned long getSkipped() {
+        return reader.getSkipped();
+    }
+
+private:
+    const Settings &settings;
+    std::vector<FILE *> &files;
+    FrameReader reader;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<Batch *> pending;
+    std::map<uint64_t, Batch *> done;
+    std::vector<Batch *> spare;
+    unsigned int inFlight = 0;
+    bool finished = false;
+    uint64_t sequence = 0;
+
+    void read(unsigned int maxInFlight) {
+        uint64_t firstFrame = 0;
+        for (;;) {
+            Batch *batch;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] { return inFlight < maxInFlight; });
+                if (spare.empty()) {
+                    batch = new Batch();
+                } else {
+                    batch = spare.back();
+                    spare.pop_back();
+                }
+            }
+
+            if (!reader.fill(files, *batch)) {
+                delete batch;
+                break;
+            }
+            batch->sequence = sequence++;
+            batch->firstFrame = firstFrame;
+            firstFrame += batch->offsets.size() - 1;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.push_back(batch);
+            ++inFlight;
+            changed.notify_all();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+        changed.notify_all();
+    }
+
+    void work() {
+        std::vector<unsigned char> expanded(maxExpandedSize);
+        for (;;) {
+            Batch *batch;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] { return !pending.empty() || finished; });
+                if (pending.empty()) return;
+                batch = pending.front();
+                pending.pop_front();
+            }
+
+            decodeBatch(settings, *batch, expanded);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            done[batch->sequence] = batch;
+            changed.notify_all();
+        }
+    }
+
+    void write() {
+        for (uint64_t next = 0;; ++next) {
+            Batch *batch;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] { return done.count(next) || (finished && next == sequence); });
+                if (!done.count(next)) break;
+                batch = done[next];
+                done.erase(next);
+            }
+
+            if (!settings.discard) {
+                fwrite(batch->output.data(), 1, batch->output.size(), stdout);
+            }
+            frames += batch->offsets.size() - 1;
+            errors += batch->errors;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            spare.push_back(batch);
+            --inFlight;
+            changed.notify_all();
+        }
+        fflush(stdout);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (unsigned int i = 0; i < spare.size(); ++i) {
+            delete spare[i];
+        }
+        spare.clear();
+    }
+};
+
+static bool loadConversion(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        perror(path);
+        return false;
+    }
+    std::string json;
+    char chunk[4096];
+    size_t count;
+    while ((count = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        json.append(chunk, count);
+    }
+    fclose(file);
+
+    std::string error;
+    if (!conversion.compile(json.c_str(), error)) {
+        fprintf(stderr, "%s: %s\n", path, error.c_str());
+        return false;
+    }
+    return true;
+}
+
+static void usage() {
+    fprintf(stderr,
+        "usage: payload-decoder [-f format] [-c conversion] [-x | -b] [-z] [-j threads] [-n] [file ...]\n"
+        "  -f  cbor (default), lpp, track, timeseries, batch, raw or abcl\n"
+        "  -c  ABCL conversion (JSON) for binary payloads; implies -f abcl\n"
+        "  -x  hex input, one frame per line (default)\n"
+        "  -b  binary input, each frame preceded by its 16-bit big-endian length\n"
+        "  -z  frames are CompressedPayload frames, expanded before decoding\n"
+        "  -j  decode threads (default: one per core)\n"
+        "  -n  decode only, no output (for benchmarking)\n");
+}
+
+int main(int argc, char **argv) {
+    Settings settings;
+    std::vector<const char *> paths;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        if (!strcmp(arg, "-f") && i + 1 < argc) {
+            const char *name = argv[++i];
+            bool found = false;
+            for (unsigned int f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f) {
+                if (!strcmp(formats[f].name, name)) {
+                    settings.decode = formats[f].decode;
+                    found = true;
+                }
+            }
+            if (!found) {
+                fprintf(stderr, "unknown format: %s\n", name);
+                return 2;
+            }
+        } else if (!strcmp(arg, "-c") && i + 1 < argc) {
+            if (!loadConversion(argv[++i]))
+                return 2;
+            settings.decode = decodeAbcl;
+        } else if (!strcmp(arg, "-x")) {
+            settings.binary = false;
+        } else if (!strcmp(arg, "-b")) {
+            settings.binary = true;
+        } else if (!strcmp(arg, "-z")) {
+            settings.compressed = true;
+        } else if (!strcmp(arg, "-j") && i + 1 < argc) {
+            settings.threads = atoi(argv[++i]);
+        } else if (!strcmp(arg, "-n")) {
+            settings.discard = true;
+        } else if (arg[0] == '-' && arg[1] != 0) {
+            usage();
+            return 2;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+
+    if (settings.decode == decodeAbcl && conversion.getFieldCount() == 0) {
+        fprintf(stderr, "-f abcl needs a conversion with at least one field (-c)\n");
+        return 2;
+    }
+
+    std::vector<FILE *> files;
+    for (unsigned int i = 0; i < paths.size(); ++i) {
+        FILE *file = strcmp(paths[i], "-") ? fopen(paths[i], "rb") : stdin;
+        if (!file) {
+            perror(paths[i]);
+            return 1;
+        }
+        files.push_back(file);
+    }
+    if (files.empty()) {
+        files.push_back(stdin);
+    }
+
+    unsigned int threads = settings.threads;
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    Pipeline pipeline(settings, files);
+    pipeline.run(threads);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    for (unsigned int i = 0; i < files.size(); ++i) {
+        if (files[i] != stdin) fclose(files[i]);
+    }
+
+    fprintf(stderr, "%llu frames, %lu malformed, %lu unreadable, %.3f s, %.0f frames/s (%u threads)\n",
+            (unsigned long long)pipeline.frames, pipeline.errors, pipeline.getSkipped(), seconds,
+            seconds > 0 ? pipeline.frames / seconds : 0, threads);
+    return 0;
+}
@@ -0,0 +1,38 @@
+#ifndef CHECK_H_
+#define CHECK_H_
+
+// A minimal assertion for the host tests: reports the failing expression and
+// carries on, and checkExit() turns the count into the exit status.
+
+#include <stdio.h>
+
+static unsigned int checkFailures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            checkFailures++; \
+        } \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance) \
+    do { \
+        double difference = (double)(actual) - (double)(expected); \
+        if (difference > (tolerance) || -difference > (tolerance)) { \
+            fprintf(stderr, "%s:%d: CHECK_NEAR(%s, %s) failed: %g vs %g\n", __FILE__, __LINE__, \
+                    #actual, #expected, (double)(actual), (double)(expected)); \
+            checkFailures++; \
+        } \
+    } while (0)
+
+inline int checkExit(const char *name) {
+    if (checkFailures > 0) {
+        fprintf(stderr, "%s: %u checks failed\n", name, checkFailures);
+        return 1;
+    }
+    printf("%s: passed\n", name);
+    return 0;
+}
+
+#endif
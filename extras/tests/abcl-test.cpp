@@ -0,0 +1,189 @@
+// Random frames written by the firmware encoders (Schema::encode, and the
+// same fields through BinaryPayload::add, addBit, addBits and addScaled),
+// read back through the ABCL conversion that Schema::describe generates.
+// Catches drift between what the device writes and what Maker is told to
+// read.
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <random>
+#include <string>
+
+#include "BinaryPayload.h"
+#include "Schema.h"
+
+#include "Abcl.h"
+#include "Check.h"
+
+static const unsigned long frames = 10000;
+
+// Collects what describe() prints.
+class TextPrint : public Print {
+public:
+    std::string text;
+
+    virtual size_t write(uint8_t c) {
+        text += (char)c;
+        return 1;
+    }
+};
+
+template<typename S> static bool compile(S &schema, AbclConversion &conversion) {
+    TextPrint json;
+    schema.describe(json);
+    std::string error;
+    if (!conversion.compile(json.text.c_str(), error)) {
+        fprintf(stderr, "generated conversion does not compile: %s\n%s", error.c_str(), json.text.c_str());
+        return false;
+    }
+    return conversion.getFieldCount() == S::count && conversion.getFrameSize() == S::size;
+}
+
+static float randomFloat(std::mt19937 &random) {
+    uint32_t bits = random();
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return isnan(value) ? 0 : value;
+}
+
+static double randomDouble(std::mt19937 &random) {
+    uint64_t bits = ((uint64_t)random() << 32) | random();
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return isnan(value) ? 0 : value;
+}
+
+// Byte-aligned fields of every kind, with packed ones in between.
+typedef Schema<
+    Field<float>, Field<bool>, Field<short>, Field<unsigned int>,
+    Flag, Bits<5>, Scaled<200, 420, 100>, Scaled<-40, 85>,
+    Field<signed char>, Field<double>, Field<char[6]>, Field<long>
+> Mixed;
+
+static void testMixed() {
+    Mixed schema("f", "b", "s", "u", "flag", "bits", "battery", "temperature", "c", "d", "text", "l");
+    AbclConversion conversion;
+    CHECK(compile(schema, conversion));
+    if (checkFailures > 0)
+        return;
+
+    std::mt19937 random(1);
+    AbclValue values[Mixed::count];
+    unsigned long mismatches = 0;
+    for (unsigned long i = 0; i < frames && mismatches < 10; ++i) {
+        float f = randomFloat(random);
+        bool b = random() & 1;
+        short s = random();
+        unsigned int u = random();
+        bool flag = random() & 1;
+        uint32_t bits = random() % 32;
+        unsigned int batterySteps = random() % 221;
+        float battery = (200 + batterySteps) / 100.0f;
+        int temperature = (int)(random() % 126) - 40;
+        signed char c = random();
+        double d = randomDouble(random);
+        char text[7] = { 0 };
+        unsigned int textLength = random() % 7;
+        for (unsigned int t = 0; t < textLength; ++t) {
+            text[t] = ' ' + random() % 95;
+        }
+        long l = (long)(((uint64_t)random() << 32) | random());
+
+        BinaryPayload fromSchema(Mixed::size);
+        CHECK(schema.encode(fromSchema, f, b, s, u, flag, bits, battery, (float)temperature, c, d, text, l));
+
+        BinaryPayload fromAdd(Mixed::size);
+        fromAdd.add(f);
+        fromAdd.add(b);
+        fromAdd.add(s);
+        fromAdd.add(u);
+        fromAdd.addBit(flag);
+        fromAdd.addBits(bits, 5);
+        fromAdd.addScaled(battery, 2.00f, 4.20f, 0.01f);
+        fromAdd.addScaled(temperature, -40, 85, 1);
+        fromAdd.add(c);
+        fromAdd.add(d);
+        fromAdd.add((const char *)text);
+        for (unsigned int t = textLength; t < 6; ++t) {
+            fromAdd.add((unsigned char)0);
+        }
+        fromAdd.add(l);
+
+        bool same = fromAdd.getSize() == Mixed::size
+            && memcmp(fromAdd.getBytes(), fromSchema.getBytes(), Mixed::size) == 0;
+        CHECK(same);
+
+        CHECK(conversion.read(fromSchema.getBytes(), fromSchema.getSize(), values));
+        unsigned int before = checkFailures;
+        CHECK(values[0].number == f);
+        CHECK(values[1].boolean == b);
+        CHECK((short)values[2].integer == s && (int64_t)values[2].integer == s);
+        CHECK(values[3].integer == u);
+        CHECK(values[4].boolean == flag);
+        CHECK(values[5].integer == bits);
+        CHECK_NEAR(values[6].number, (200 + batterySteps) / 100.0, 1e-9);
+        CHECK_NEAR(values[7].number, temperature, 1e-9);
+        CHECK((int64_t)values[8].integer == c);
+        CHECK(values[9].number == d);
+        CHECK(values[10].length == textLength && memcmp(values[10].text, text, textLength) == 0);
+        CHECK((int64_t)values[11].integer == l);
+        if (!same || checkFailures != before) {
+            mismatches++;
+        }
+    }
+}
+
+// Packed fields only, including ones that straddle several bytes and a
+// scaled range with negative values.
+typedef Schema<Flag, Bits<32>, Scaled<-1000000, 1000000, 1000>, Bits<3>, Field<unsigned char>, Bits<12>> Packed;
+
+static void testPacked() {
+    Packed schema("flag", "counter", "position", "mode", "byte", "tail");
+    AbclConversion conversion;
+    CHECK(compile(schema, conversion));
+    if (checkFailures > 0)
+        return;
+
+    std::mt19937 random(2);
+    AbclValue values[Packed::count];
+    for (unsigned long i = 0; i < frames && checkFailures < 10; ++i) {
+        bool flag = random() & 1;
+        uint32_t counter = random();
+        long positionSteps = (long)(random() % 2000001) - 1000000;
+        float position = positionSteps / 1000.0f;
+        uint32_t mode = random() % 8;
+        unsigned char byte = random();
+        uint32_t tail = random() % 4096;
+
+        BinaryPayload fromSchema(Packed::size);
+        CHECK(schema.encode(fromSchema, flag, counter, position, mode, byte, tail));
+
+        BinaryPayload fromAdd(Packed::size);
+        fromAdd.addBit(flag);
+        fromAdd.addBits(counter, 32);
+        fromAdd.addScaled(position, -1000, 1000, 0.001f);
+        fromAdd.addBits(mode, 3);
+        fromAdd.add(byte);
+        fromAdd.addBits(tail, 12);
+
+        CHECK(fromAdd.getSize() == Packed::size);
+        CHECK(memcmp(fromAdd.getBytes(), fromSchema.getBytes(), Packed::size) == 0);
+
+        CHECK(conversion.read(fromSchema.getBytes(), fromSchema.getSize(), values));
+        CHECK(values[0].boolean == flag);
+        CHECK(values[1].integer == counter);
+        // A float holds the position to about 0.0001 at 1000.
+        CHECK_NEAR(values[2].number, positionSteps / 1000.0, 0.0006);
+        CHECK(values[3].integer == mode);
+        CHECK(values[4].integer == byte);
+        CHECK(values[5].integer == tail);
+    }
+}
+
+int main() {
+    testMixed();
+    testPacked();
+    return checkExit("abcl-test");
+}
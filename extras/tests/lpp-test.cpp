@@ -0,0 +1,181 @@
+// LppPayload against LppReader, and against CborPayload for size.
+
+#include <math.h>
+#include <string.h>
+
+#include "CborPayload.h"
+#include "GeoLocation.h"
+#include "LppPayload.h"
+
+#include "Check.h"
+
+struct Expected {
+    uint8_t channel;
+    uint8_t type;
+    unsigned int count;
+    float values[3];
+    float tolerance;
+};
+
+static void testRoundTrip() {
+    LppPayload payload(128);
+    CHECK(payload.addDigitalInput(1, 1));
+    CHECK(payload.addDigitalOutput(2, 0));
+    CHECK(payload.addAnalogInput(3, -12.34f));
+    CHECK(payload.addAnalogOutput(4, 3.3f));
+    CHECK(payload.addLuminosity(5, 40000));
+    CHECK(payload.addPresence(6, 1));
+    CHECK(payload.addTemperature(7, -5.25f));
+    CHECK(payload.addRelativeHumidity(8, 55.5f));
+    CHECK(payload.addAccelerometer(9, 0.012f, -0.981f, 1.5f));
+    CHECK(payload.addBarometricPressure(10, 1013.2f));
+    CHECK(payload.addGyrometer(11, -120.5f, 0.25f, 300));
+    CHECK(payload.addGPS(12, GeoLocation(51.0543f, 3.7174f, 12.34f)));
+    CHECK(payload.addGPS(13, -33.8688f, 151.2093f, -2.5f));
+
+    const Expected expected[] = {
+        { 1, LppPayload::digitalInput, 1, { 1 }, 0 },
+        { 2, LppPayload::digitalOutput, 1, { 0 }, 0 },
+        { 3, LppPayload::analogInput, 1, { -12.34f }, 0.005f },
+        { 4, LppPayload::analogOutput, 1, { 3.3f }, 0.005f },
+        { 5, LppPayload::luminosity, 1, { 40000 }, 0 },
+        { 6, LppPayload::presence, 1, { 1 }, 0 },
+        { 7, LppPayload::temperature, 1, { -5.25f }, 0.05f },
+        { 8, LppPayload::relativeHumidity, 1, { 55.5f }, 0.25f },
+        { 9, LppPayload::accelerometer, 3, { 0.012f, -0.981f, 1.5f }, 0.0005f },
+        { 10, LppPayload::barometricPressure, 1, { 1013.2f }, 0.05f },
+        { 11, LppPayload::gyrometer, 3, { -120.5f, 0.25f, 300 }, 0.005f },
+        { 12, LppPayload::gps, 3, { 51.0543f, 3.7174f, 12.34f }, 0.00005f },
+        { 13, LppPayload::gps, 3, { -33.8688f, 151.2093f, -2.5f }, 0.00005f },
+    };
+    const unsigned int expectedCount = sizeof(expected) / sizeof(expected[0]);
+    CHECK(payload.getSize() == 2 * expectedCount + 1 + 1 + 2 + 2 + 2 + 1 + 2 + 1 + 6 + 2 + 6 + 9 + 9);
+
+    LppReader reader(payload.getBytes(), payload.getSize());
+    uint8_t channel, type;
+    float values[3];
+    unsigned int count;
+    unsigned int read = 0;
+    while (reader.next(channel, type, values, count)) {
+        if (read < expectedCount) {
+            const Expected &want = expected[read];
+            CHECK(channel == want.channel);
+            CHECK(type == want.type);
+            CHECK(count == want.count);
+            for (unsigned int i = 0; i < count && i < 3; ++i) {
+                // GPS altitude is in centimeters, the coordinates in 0.0001 degree.
+                float tolerance = type == LppPayload::gps && i == 2 ? 0.005f : want.tolerance;
+                CHECK_NEAR(values[i], want.values[i], tolerance + 1e-6 * (want.values[i] < 0 ? -want.values[i] : want.values[i]));
+            }
+        }
+        read++;
+    }
+    CHECK(reader.isValid());
+    CHECK(read == expectedCount);
+}
+
+static void testCapacity() {
+    LppPayload payload(7);
+    CHECK(payload.addTemperature(1, 20));
+    CHECK(!payload.addTemperature(2, 21)); // 4 more bytes do not fit in 3
+    CHECK(payload.getSize() == 4);
+    CHECK(payload.addPresence(3, 1));
+    CHECK(payload.getSize() == 7);
+
+    payload.reset();
+    CHECK(payload.getSize() == 0);
+}
+
+static void testMalformed() {
+    const unsigned char unknownType[] = { 1, 200, 0 };
+    LppReader unknown(unknownType, sizeof(unknownType));
+    uint8_t channel, type;
+    float values[3];
+    unsigned int count;
+    CHECK(!unknown.next(channel, type, values, count));
+    CHECK(!unknown.isValid());
+
+    const unsigned char truncated[] = { 1, LppPayload::temperature, 0x00, 0xD7, 2, LppPayload::temperature, 0x00 };
+    LppReader reader(truncated, sizeof(truncated));
+    CHECK(reader.next(channel, type, values, count));
+    CHECK_NEAR(values[0], 21.5f, 0.001f);
+    CHECK(!reader.next(channel, type, values, count));
+    CHECK(!reader.isValid());
+}
+
+// Values outside the range of their type, or NaN, are refused and leave the
+// payload as it was, rather than wrapping around.
+static void testRange() {
+    LppPayload payload(128);
+    CHECK(payload.addTemperature(1, 3276.7f));
+    CHECK(payload.addTemperature(2, -3276.8f));
+    CHECK(payload.addRelativeHumidity(3, 127.5f));
+    CHECK(payload.addGPS(4, 838.86f, -838.86f, 83886.07f));
+    unsigned int size = payload.getSize();
+
+    CHECK(!payload.addTemperature(5, 3276.8f));
+    CHECK(!payload.addTemperature(5, -3277));
+    CHECK(!payload.addTemperature(5, 1e30f));
+    CHECK(!payload.addTemperature(5, NAN));
+    CHECK(!payload.addTemperature(5, INFINITY));
+    CHECK(!payload.addRelativeHumidity(5, 128));
+    CHECK(!payload.addRelativeHumidity(5, -1));
+    CHECK(!payload.addAnalogInput(5, 327.68f));
+    CHECK(!payload.addBarometricPressure(5, -1));
+    CHECK(!payload.addAccelerometer(5, 0, 0, NAN));
+    CHECK(!payload.addGPS(5, 838.87f, 0, 0));
+    CHECK(!payload.addGPS(5, 0, -838.87f, 0));
+    CHECK(!payload.addGPS(5, 0, 0, 83886.1f));
+    CHECK(payload.getSize() == size);
+
+    LppReader reader(payload.getBytes(), payload.getSize());
+    uint8_t channel, type;
+    float values[3];
+    unsigned int count;
+    CHECK(reader.next(channel, type, values, count) && channel == 1);
+    CHECK_NEAR(values[0], 3276.7f, 0.01f);
+    CHECK(reader.next(channel, type, values, count) && channel == 2);
+    CHECK_NEAR(values[0], -3276.8f, 0.01f);
+    CHECK(reader.next(channel, type, values, count) && channel == 3);
+    CHECK_NEAR(values[0], 127.5f, 0.001f);
+    CHECK(reader.next(channel, type, values, count) && channel == 4);
+    CHECK_NEAR(values[0], 838.86f, 0.0002f);
+    CHECK_NEAR(values[1], -838.86f, 0.0002f);
+    CHECK_NEAR(values[2], 83886.07f, 0.01f);
+    CHECK(!reader.next(channel, type, values, count));
+    CHECK(reader.isValid());
+}
+
+// The README's example: the same three values, as LPP and as CBOR.
+static void testSizeAgainstCbor() {
+    GeoLocation location(51.0543f, 3.7174f, 12.3f);
+
+    LppPayload lpp;
+    CHECK(lpp.addTemperature(1, 21.5f));
+    CHECK(lpp.addRelativeHumidity(2, 55));
+    CHECK(lpp.addGPS(3, location));
+
+    char temperature[] = "1";
+    char humidity[] = "2";
+    char gps[] = "3";
+    CborPayload cbor;
+    CHECK(cbor.set(temperature, 21.5f));
+    CHECK(cbor.set(humidity, 55));
+    CHECK(cbor.set(gps, location));
+
+    // 4 + 3 + 11 bytes, against a map header, three one-letter names, a float,
+    // a small integer and a tagged array of three floats.
+    CHECK(lpp.getSize() == 18);
+    CHECK(cbor.getSize() == 1 + 3 * 2 + 5 + 2 + 2 + 1 + 3 * 5);
+    CHECK(lpp.getSize() < cbor.getSize());
+    printf("temperature, humidity and location: %u bytes as LPP, %u as CBOR\n", lpp.getSize(), cbor.getSize());
+}
+
+int main() {
+    testRoundTrip();
+    testCapacity();
+    testMalformed();
+    testRange();
+    testSizeAgainstCbor();
+    return checkExit("lpp-test");
+}
@@ -0,0 +1,31 @@
+#!/bin/sh
+# Builds the host tests against the SDK sources and runs them. Extra
+# arguments are passed to the compiler, e.g. -fsanitize=address,undefined.
+
+cd "$(dirname "$0")" || exit 1
+
+CXX=${CXX:-g++}
+SRC=../../src
+BUILD=${BUILD:-build}
+mkdir -p "$BUILD" || exit 1
+
+failed=0
+
+# run name sources...
+run() {
+    name=$1
+    shift
+    if ! "$CXX" -std=c++11 -O1 -Wall -Wextra -I../fleet-simulator -I"$SRC" $FLAGS "$@" -o "$BUILD/$name"; then
+        echo "$name: build failed" >&2
+        failed=1
+    elif ! "$BUILD/$name"; then
+        failed=1
+    fi
+}
+
+FLAGS="$*"
+
+run lpp-test lpp-test.cpp $SRC/LppPayload.cpp $SRC/CborPayload.cpp $SRC/GeoLocation.cpp
+run abcl-test -I../payload-decoder abcl-test.cpp ../payload-decoder/Abcl.cpp $SRC/BinaryPayload.cpp $SRC/GeoLocation.cpp
+
+exit $failed
@@ -0,0 +1,261 @@
+#include <string.h>
+
+#include "AdaptivePayload.h"
+#include "ByteOrder.h"
+#include "Varint.h"
+
+// Bounded output that keeps counting past its limit, so that rendering
+// doubles as measuring.
+struct RenderOutput {
+    unsigned char *out;
+    unsigned int limit;
+    unsigned int size;
+
+    void put(unsigned char value) {
+        if (out != NULL && size < limit) {
+            out[size] = value;
+        }
+        size++;
+    }
+
+    void put(const unsigned char *data, unsigned int length) {
+        if (out != NULL && size + length <= limit) {
+            memcpy(out + size, data, length);
+        }
+        size += length;
+    }
+
+    void putHead(unsigned char majorType, uint32_t value) {
+        majorType <<= 5;
+        if (value < 24) {
+            put(majorType | value);
+        } else if (value < 256) {
+            put(majorType | 24);
+            put(value);
+        } else if (value < 65536) {
+            put(majorType | 25);
+            put(value >> 8);
+            put(value);
+        } else {
+            put(majorType | 26);
+            put(value >> 24);
+            put(value >> 16);
+            put(value >> 8);
+            put(value);
+        }
+    }
+
+    void putInteger(int32_t value) {
+        if (value < 0) {
+            putHead(1, (uint32_t)(-(value + 1)));
+        } else {
+            putHead(0, (uint32_t)value);
+        }
+    }
+
+    void putNumber(float value) {
+        if (value >= -2147483648.0f && value < 2147483648.0f && (float)(int32_t)value == value) {
+            putInteger((int32_t)value);
+            return;
+        }
+
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        int exponent = (int)((bits >> 23) & 0xFF) - 127;
+        if (exponent >= -14 && exponent <= 15 && (bits & 0x1FFF) == 0) {
+            uint16_t half = ((bits >> 16) & 0x8000) | ((exponent + 15) << 10) | ((bits >> 13) & 0x3FF);
+            put(0xF9);
+            put(half >> 8);
+            put(half);
+            return;
+        }
+
+        unsigned char bytes[4];
+        storeBigEndian(bytes, value);
+        put(0xFA);
+        put(bytes, 4);
+    }
+};
+
+AdaptivePayload::AdaptivePayload(unsigned int capacity, unsigned int assets) {
+    this->capacity = capacity;
+    this->buffer = new unsigned char[capacity];
+    this->entryCapacity = assets;
+    this->entries = new Entry[assets];
+}
+
+AdaptivePayload::~AdaptivePayload() {
+    delete[] buffer;
+    delete[] entries;
+}
+
+unsigned char *AdaptivePayload::getBytes() {
+    return buffer;
+}
+
+unsigned int AdaptivePayload::getSize() {
+    return size;
+}
+
+AdaptivePayload::Codec AdaptivePayload::getCodec() {
+    return codec;
+}
+
+unsigned int AdaptivePayload::getPort() {
+    return codec == none ? 0 : ports[codec];
+}
+
+void AdaptivePayload::setPort(Codec codec, unsigned int port) {
+    if (codec != none) {
+        ports[codec] = port;
+    }
+}
+
+void AdaptivePayload::reset() {
+    for (unsigned int i = 0; i < entryCount; ++i) {
+        entries[i].type = unset;
+    }
+    size = 0;
+    codec = none;
+}
+
+AdaptivePayload::Entry *AdaptivePayload::find(const char *assetName) {
+    for (unsigned int i = 0; i < entryCount; ++i) {
+        if (strcmp(entries[i].name, assetName) == 0) {
+            return &entries[i];
+        }
+    }
+    if (entryCount >= entryCapacity) {
+        return NULL;
+    }
+    Entry *entry = &entries[entryCount++];
+    entry->name = assetName;
+    entry->type = unset;
+    return entry;
+}
+
+template<> bool AdaptivePayload::set(const char *assetName, bool value) {
+    Entry *entry = find(assetName);
+    if (entry == NULL)
+        return false;
+
+    entry->type = boolean;
+    entry->value.boolean = value;
+    codec = none;
+    return true;
+}
+
+template<> bool AdaptivePayload::set(const char *assetName, long value) {
+    Entry *entry = find(assetName);
+    if (entry == NULL)
+        return false;
+
+    entry->type = integer;
+    entry->value.integer = value;
+    codec = none;
+    return true;
+}
+
+template<> bool AdaptivePayload::set(const char *assetName, int value) {
+    return set(assetName, (long)value);
+}
+
+template<> bool AdaptivePayload::set(const char *assetName, float value) {
+    Entry *entry = find(assetName);
+    if (entry == NULL)
+        return false;
+
+    entry->type = number;
+    entry->value.number = value;
+    codec = none;
+    return true;
+}
+
+template<> bool AdaptivePayload::set(const char *assetName, double value) {
+    return set(assetName, (float)value);
+}
+
+unsigned int AdaptivePayload::render(Codec codec, unsigned char *out, unsigned int limit) {
+    RenderOutput output = { out, limit, 0 };
+
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < entryCount; ++i) {
+        if (entries[i].type != unset) count++;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    if (codec == binary) {
+        if (count != entryCount) {
+            return 0;
+        }
+        for (unsigned int i = 0; i < entryCount; ++i) {
+            Entry &entry = entries[i];
+            if (entry.type == boolean) {
+                output.put(entry.value.boolean ? 1 : 0);
+            } else if (entry.type == integer) {
+                unsigned char varint[maxVarintSize];
+                output.put(varint, encodeVarint(varint, zigzagEncode(entry.value.integer)));
+            } else {
+                unsigned char bytes[4];
+                storeBigEndian(bytes, entry.value.number);
+                output.put(bytes, 4);
+            }
+        }
+        return output.size;
+    }
+
+    output.putHead(5, count);
+    for (unsigned int i = 0; i < entryCount; ++i) {
+        Entry &entry = entries[i];
+        if (entry.type == unset) {
+            continue;
+        }
+        if (codec == cbor) {
+            unsigned int length = strlen(entry.name);
+            output.putHead(3, length);
+            output.put((const unsigned char *)entry.name, length);
+        } else {
+            output.putHead(0, i);
+        }
+        if (entry.type == boolean) {
+            output.put(entry.value.boolean ? 0xF5 : 0xF4);
+        } else if (entry.type == integer) {
+            output.putInteger(entry.value.integer);
+        } else {
+            output.putNumber(entry.value.number);
+        }
+    }
+    return output.size;
+}
+
+unsigned int AdaptivePayload::getSize(Codec codec) {
+    return codec == none ? 0 : render(codec, NULL, 0);
+}
+
+bool AdaptivePayload::select(unsigned int maxSize) {
+    if (maxSize > capacity) {
+        maxSize = capacity;
+    }
+
+    codec = none;
+    size = 0;
+    unsigned int best = 0;
+    for (int candidate = cbor; candidate != none; ++candidate) {
+        if (ports[candidate] == 0) {
+            continue;
+        }
+        unsigned int candidateSize = getSize((Codec)candidate);
+        if (candidateSize > 0 && candidateSize <= maxSize && (codec == none || candidateSize < best)) {
+            codec = (Codec)candidate;
+            best = candidateSize;
+        }
+    }
+    if (codec == none) {
+        return false;
+    }
+
+    size = render(codec, buffer, capacity);
+    return true;
+}
@@ -0,0 +1,81 @@
+#ifndef ADAPTIVE_PAYLOAD_H_
+#define ADAPTIVE_PAYLOAD_H_
+
+#include "Payload.h"
+
+#include <stdint.h>
+
+// Takes asset values once and renders them in whichever encoding comes out
+// smallest:
+//
+//   cbor         {"name": value, ...}, the map CborPayload sends
+//   cborIndexed  {index: value, ...}, index being the order in which the
+//                asset was first set
+//   binary       values only, in index order: booleans as 1 byte, integers
+//                as zigzag varints, other numbers as 4 byte floats.
+//                Only possible when every known asset has a value.
+//
+// CBOR numbers take the shortest exact form (integer, half or single
+// precision float). The chosen encoding is identified by its port, so send
+// with it. Only cbor is on by default, on port 1: the backend has no decoder
+// for the other two yet. setPort() turns them on once it does; a port of 0
+// leaves an encoding out.
+//
+//   if (payload.select(modem.getDataRateMaxPayloadSize())) {
+//       LoRaOptions options(payload.getPort());
+//       modem.send(payload, options);
+//   }
+class AdaptivePayload : public Payload {
+public:
+    enum Codec { cbor, cborIndexed, binary, none };
+
+    AdaptivePayload(unsigned int capacity = 51, unsigned int assets = 8);
+    ~AdaptivePayload();
+    AdaptivePayload(const AdaptivePayload &) = delete;
+    AdaptivePayload &operator=(const AdaptivePayload &) = delete;
+
+    template<typename T> bool set(const char *assetName, T value);
+
+    // Renders the smallest enabled encoding of at most maxSize bytes.
+    // Returns false if none fits.
+    bool select(unsigned int maxSize);
+    Codec getCodec();
+    unsigned int getPort();
+    void setPort(Codec codec, unsigned int port);
+    unsigned int getSize(Codec codec);
+
+    virtual unsigned char* getBytes();
+    virtual unsigned int getSize();
+
+    // Clears the values; assets keep their index.
+    virtual void reset();
+
+private:
+    enum ValueType { unset, boolean, integer, number };
+
+    struct Entry {
+        const char *name;
+        ValueType type;
+        union {
+            bool boolean;
+            int32_t integer;
+            float number;
+        } value;
+    };
+
+    unsigned char *buffer;
+    unsigned int capacity;
+    unsigned int size = 0;
+
+    Entry *entries;
+    unsigned int entryCapacity;
+    unsigned int entryCount = 0;
+
+    Codec codec = none;
+    unsigned int ports[3] = { 1, 0, 0 };
+
+    Entry *find(const char *assetName);
+    unsigned int render(Codec codec, unsigned char *out, unsigned int limit);
+};
+
+#endif
@@ -2,4 +2,17 @@
 #include "OTAACredentials.h"
 #include "LoRaModem.h"
 #include "CborPayload.h"
-#include "BinaryPayload.h"
\ No newline at end of file
+#include "Library-Arduino-Cbor/CborCursor.h"
+#include "CborSchema.h"
+#include "BinaryPayload.h"
+#include "PayloadView.h"
+#include "TrackPayload.h"
+#include "TimeSeriesPayload.h"
+#include "LppPayload.h"
+#include "CborFramePayload.h"
+#include "AdaptivePayload.h"
+#include "CompressedPayload.h"
+#include "UplinkJournal.h"
+#include "FrameCounterStore.h"
+#include "Asset.h"
+#include "Schema.h"
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include "Asset.h"
+
+AssetBase::AssetBase(AssetRegistry &registry, const char *name, unsigned long maxSilence) {
+    this->name = name;
+    this->maxSilence = maxSilence;
+    registry.add(this);
+}
+
+const char *AssetBase::getName() {
+    return name;
+}
+
+bool AssetBase::hasValue() {
+    return valueSet;
+}
+
+bool AssetBase::isDue(unsigned long now) {
+    if (!valueSet)
+        return false;
+
+    if (!sent)
+        return true;
+
+    if (maxSilence > 0 && now - lastSentAt >= maxSilence)
+        return true;
+
+    return hasChanged();
+}
+
+void AssetRegistry::add(AssetBase *asset) {
+    if (last == NULL) {
+        first = asset;
+    } else {
+        last->next = asset;
+    }
+    last = asset;
+}
+
+unsigned int AssetRegistry::getCount() {
+    unsigned int count = 0;
+    for (AssetBase *asset = first; asset != NULL; asset = asset->next) {
+        count++;
+    }
+    return count;
+}
+
+bool AssetRegistry::build(CborPayload &payload, unsigned long now) {
+    payload.reset();
+
+    leftover = false;
+    unsigned int count = 0;
+    for (AssetBase *asset = first; asset != NULL; asset = asset->next) {
+        asset->pending = false;
+        if (!asset->isDue(now))
+            continue;
+
+        if (asset->write(payload)) {
+            asset->pending = true;
+            count++;
+        } else {
+            leftover = true;
+        }
+    }
+    return count > 0;
+}
+
+bool AssetRegistry::hasPending() {
+    return leftover;
+}
+
+void AssetRegistry::commit(unsigned long now) {
+    for (AssetBase *asset = first; asset != NULL; asset = asset->next) {
+        if (asset->pending) {
+            asset->markSent();
+            asset->sent = true;
+            asset->lastSentAt = now;
+            asset->pending = false;
+        }
+    }
+}
@@ -0,0 +1,116 @@
+#ifndef ASSET_H_
+#define ASSET_H_
+
+#include "Arduino.h"
+#include "CborPayload.h"
+
+class AssetRegistry;
+
+// A value that is only sent when it matters: when it moved more than its
+// deadband away from the value last sent, or when it has not been sent for
+// maxSilence milliseconds (0: no heartbeat).
+//
+//   AssetRegistry assets;
+//   Asset<float> temperature(assets, "5", 0.5, 3600000);
+//
+//   temperature.set(readTemperature());
+//   if (assets.build(payload) && modem.send(payload)) {
+//       assets.commit();
+//   }
+class AssetBase {
+public:
+    AssetBase(AssetRegistry &registry, const char *name, unsigned long maxSilence);
+
+    const char *getName();
+    bool hasValue();
+
+    // Whether the asset should go into the next payload.
+    bool isDue(unsigned long now);
+
+protected:
+    bool valueSet = false;
+
+    virtual bool hasChanged() = 0;
+    virtual bool write(CborPayload &payload) = 0;
+    virtual void markSent() = 0;
+
+private:
+    friend class AssetRegistry;
+
+    const char *name;
+    unsigned long maxSilence;
+    unsigned long lastSentAt = 0;
+    bool sent = false;
+    bool pending = false;
+    AssetBase *next = NULL;
+};
+
+template<typename T> class Asset : public AssetBase {
+public:
+    Asset(AssetRegistry &registry, const char *name, T deadband = T(), unsigned long maxSilence = 0)
+        : AssetBase(registry, name, maxSilence), deadband(deadband) { }
+
+    void set(T value) {
+        this->value = value;
+        valueSet = true;
+    }
+
+    T get() {
+        return value;
+    }
+
+    T getLastSent() {
+        return lastSent;
+    }
+
+protected:
+    virtual bool hasChanged() {
+        T difference = value > lastSent ? value - lastSent : lastSent - value;
+        return difference > deadband;
+    }
+
+    virtual bool write(CborPayload &payload) {
+        pendingValue = value;
+        return payload.set(const_cast<char *>(getName()), value);
+    }
+
+    virtual void markSent() {
+        lastSent = pendingValue;
+    }
+
+private:
+    T value = T();
+    T lastSent = T();
+    T pendingValue = T();
+    T deadband;
+};
+
+template<> inline bool Asset<bool>::hasChanged() {
+    return value != lastSent;
+}
+
+class AssetRegistry {
+public:
+    // Resets the payload and adds every asset that is due. Returns false if
+    // nothing was added. Due assets that did not fit stay due; hasPending()
+    // tells whether there are any, to build and send another frame.
+    bool build(CborPayload &payload, unsigned long now = millis());
+    bool hasPending();
+
+    // Records the assets of the last build() as sent. Call it once the
+    // payload went out.
+    void commit(unsigned long now = millis());
+
+    unsigned int getCount();
+
+private:
+    friend class AssetBase;
+
+    AssetBase *first = NULL;
+    AssetBase *last = NULL;
+    bool leftover = false;
+
+    void add(AssetBase *asset);
+};
+
+#endif
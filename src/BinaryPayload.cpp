@@ -3,13 +3,13 @@
 #include "Arduino.h"
 
 #include "BinaryPayload.h"
+#include "ByteOrder.h"
+#include "Varint.h"
 #include "GeoLocation.h"
 
 BinaryPayload::BinaryPayload(unsigned int capacity) {
     this->capacity = capacity;
     buffer = new unsigned char[capacity];
-    uint16_t endianCheck = 0x1;
-    littleEndian = ((char*)&endianCheck)[0] == 1;
     releaseBuffer = true;
 }
 
@@ -20,8 +20,6 @@ BinaryPayload::BinaryPayload(unsigned char *buffer, unsigned int length, unsigne
     this->buffer = buffer;
     this->capacity = capacity;
     offset = length;
-    uint16_t endianCheck = 0x1;
-    littleEndian = ((char*)&endianCheck)[0] == 1;
     releaseBuffer = false;
 }
 
@@ -31,6 +29,34 @@ BinaryPayload::~BinaryPayload() {
     }
 }
 
+BinaryPayload::BinaryPayload(BinaryPayload &&other) {
+    *this = static_cast<BinaryPayload &&>(other);
+}
+
+BinaryPayload &BinaryPayload::operator=(BinaryPayload &&other) {
+    if (this == &other)
+        return *this;
+
+    if (releaseBuffer) {
+        delete[] buffer;
+    }
+    buffer = other.buffer;
+    offset = other.offset;
+    capacity = other.capacity;
+    bitPosition = other.bitPosition;
+    bitEnd = other.bitEnd;
+    releaseBuffer = other.releaseBuffer;
+
+    // Left empty and without a buffer, like a payload of capacity 0.
+    other.buffer = NULL;
+    other.offset = 0;
+    other.capacity = 0;
+    other.bitPosition = 0;
+    other.bitEnd = 0;
+    other.releaseBuffer = false;
+    return *this;
+}
+
 unsigned char *BinaryPayload::getBytes() {
     return buffer;
 }
@@ -41,24 +67,96 @@ unsigned int BinaryPayload::getSize() {
 
 void BinaryPayload::reset() {
 	this->offset = 0;
+	this->bitPosition = 0;
+	this->bitEnd = 0;
 }
 
-template<typename T> bool BinaryPayload::add(T t) {
-    auto *arr = static_cast<unsigned char*>(static_cast<void*>(&t));
+unsigned char *BinaryPayload::reserve(unsigned int length) {
+    if (length + offset > capacity)
+        return NULL;
 
-    if (sizeof(t) + offset > capacity)
+    unsigned char *slot = buffer + offset;
+    offset += length;
+    return slot;
+}
+
+bool BinaryPayload::addBits(uint32_t value, uint8_t bits) {
+    if (bits == 0 || bits > 32)
         return false;
 
-    if (littleEndian) {
-        for (int i = sizeof(t) - 1; i >= 0; --i) {
-            buffer[offset++] = arr[i];
-        }
-    } else {
-        for (int i = 0; i < sizeof(t); ++i) {
-            buffer[offset++] = arr[i];
-        }
+    unsigned long position = (bitEnd == offset) ? bitPosition : offset * 8UL;
+    unsigned int end = (position + bits + 7) / 8;
+    if (end > capacity)
+        return false;
+
+    memset(buffer + offset, 0, end - offset);
+    storeBits(buffer, position, value, bits);
+
+    bitPosition = position + bits;
+    offset = end;
+    bitEnd = end;
+    return true;
+}
+
+bool BinaryPayload::addBit(bool value) {
+    return addBits(value ? 1 : 0, 1);
+}
+
+bool BinaryPayload::addScaled(float value, float min, float max, float resolution) {
+    if (value < min) value = min;
+    if (value > max) value = max;
+    return addBits((uint32_t)((value - min) / resolution + 0.5f), scaledBits(min, max, resolution));
+}
+
+uint8_t BinaryPayload::scaledBits(float min, float max, float resolution) {
+    uint32_t steps = (max - min) / resolution + 0.5f;
+    uint8_t bits = 1;
+    while (bits < 32 && (steps >> bits) != 0) {
+        bits++;
     }
+    return bits;
+}
 
+bool BinaryPayload::addVarint(uint32_t value) {
+    if (varintSize(value) + offset > capacity)
+        return false;
+
+    offset += encodeVarint(buffer + offset, value);
+    return true;
+}
+
+bool BinaryPayload::addSignedVarint(int32_t value) {
+    return addVarint(zigzagEncode(value));
+}
+
+bool BinaryPayload::addCompact(GeoLocation location) {
+    unsigned char *out = reserve(location.getCompactSize());
+    if (out == NULL)
+        return false;
+
+    location.toCompact(out);
+    return true;
+}
+
+template<typename T> bool BinaryPayload::add(T t) {
+    if (sizeof(t) + offset > capacity)
+        return false;
+
+    storeBigEndian(buffer + offset, t);
+    offset += sizeof(t);
+    return true;
+}
+
+template<typename T> bool BinaryPayload::add(const T *values, unsigned int count) {
+    if (count * sizeof(T) + offset > capacity)
+        return false;
+
+    unsigned char *out = buffer + offset;
+    for (unsigned int i = 0; i < count; ++i) {
+        storeBigEndian(out, values[i]);
+        out += sizeof(T);
+    }
+    offset += count * sizeof(T);
     return true;
 }
 
@@ -107,4 +205,22 @@ template bool BinaryPayload::add(int t);
 template bool BinaryPayload::add(bool t);
 template bool BinaryPayload::add(float t);
 template bool BinaryPayload::add(double t);
-template bool BinaryPayload::add(GeoLocation location);
\ No newline at end of file
+template bool BinaryPayload::add(GeoLocation location);
+template bool BinaryPayload::add(signed char t);
+template bool BinaryPayload::add(unsigned char t);
+template bool BinaryPayload::add(short t);
+template bool BinaryPayload::add(unsigned short t);
+template bool BinaryPayload::add(unsigned int t);
+template bool BinaryPayload::add(long t);
+template bool BinaryPayload::add(unsigned long t);
+
+template bool BinaryPayload::add(const signed char *values, unsigned int count);
+template bool BinaryPayload::add(const unsigned char *values, unsigned int count);
+template bool BinaryPayload::add(const short *values, unsigned int count);
+template bool BinaryPayload::add(const unsigned short *values, unsigned int count);
+template bool BinaryPayload::add(const int *values, unsigned int count);
+template bool BinaryPayload::add(const unsigned int *values, unsigned int count);
+template bool BinaryPayload::add(const long *values, unsigned int count);
+template bool BinaryPayload::add(const unsigned long *values, unsigned int count);
+template bool BinaryPayload::add(const float *values, unsigned int count);
+template bool BinaryPayload::add(const double *values, unsigned int count);
\ No newline at end of file
@@ -5,15 +5,49 @@
 #include <string.h>
 #include <stdint.h>
 
+class GeoLocation;
+
 class BinaryPayload : public Payload {
 public:
+    // Wraps a buffer the caller owns, holding length bytes, without copying.
     BinaryPayload(unsigned char *bytes, unsigned int length, unsigned int capacity = 0);
     BinaryPayload(unsigned int capacity = 51);
 
     ~BinaryPayload();
 
+    // Moving hands the buffer over; copying would leave two owners.
+    BinaryPayload(BinaryPayload &&other);
+    BinaryPayload &operator=(BinaryPayload &&other);
+    BinaryPayload(const BinaryPayload &) = delete;
+    BinaryPayload &operator=(const BinaryPayload &) = delete;
+
     template<typename T> bool add(T t);
 
+    // Appends count numeric samples at once, with a single capacity check.
+    template<typename T> bool add(const T *values, unsigned int count);
+
+    // Bit-level fields, packed MSB-first. Consecutive bit fields share bytes;
+    // any byte-level add() in between starts a fresh byte.
+    bool addBits(uint32_t value, uint8_t bits);
+    bool addBit(bool value);
+
+    // Stores value as (value - min) / resolution in the fewest bits that
+    // cover [min, max]; values outside the range are clamped.
+    bool addScaled(float value, float min, float max, float resolution);
+    static uint8_t scaledBits(float min, float max, float resolution);
+
+    // Platform-independent integers: LEB128 varints, zigzag-mapped when
+    // signed, so small values take a single byte (see Varint.h).
+    bool addVarint(uint32_t value);
+    bool addSignedVarint(int32_t value);
+
+    // Adds the location in its 6 or 8 byte compact form (see GeoLocation).
+    bool addCompact(GeoLocation location);
+
+    // Claims the next length bytes for the caller to fill in,
+    // or returns NULL if they don't fit.
+    unsigned char *reserve(unsigned int length);
+
     virtual unsigned char* getBytes();
     virtual unsigned int getSize();
     virtual void reset();
@@ -23,8 +57,12 @@ private:
     unsigned int offset = 0;
     unsigned int capacity;
 
+    // Position of the next free bit, valid while no byte-level data has been
+    // appended since the last bit field (offset == bitEnd).
+    unsigned long bitPosition = 0;
+    unsigned int bitEnd = 0;
+
     bool releaseBuffer = true;
-    bool littleEndian;
 };
 
 #endif
@@ -0,0 +1,92 @@
+#ifndef BYTE_ORDER_H_
+#define BYTE_ORDER_H_
+
+#include <string.h>
+#include <stdint.h>
+
+// Payloads are big-endian on the wire. The host byte order is fixed per
+// target, so the conversion is decided by the compiler instead of being
+// probed at runtime.
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define HOST_LITTLE_ENDIAN 0
+#else
+#define HOST_LITTLE_ENDIAN 1
+#endif
+
+template<unsigned int size> struct UnsignedOfSize;
+template<> struct UnsignedOfSize<1> { typedef uint8_t Type; };
+template<> struct UnsignedOfSize<2> { typedef uint16_t Type; };
+template<> struct UnsignedOfSize<4> { typedef uint32_t Type; };
+template<> struct UnsignedOfSize<8> { typedef uint64_t Type; };
+
+template<unsigned int size> struct ByteSwap;
+template<> struct ByteSwap<1> { static uint8_t swap(uint8_t bits) { return bits; } };
+template<> struct ByteSwap<2> { static uint16_t swap(uint16_t bits) { return __builtin_bswap16(bits); } };
+template<> struct ByteSwap<4> { static uint32_t swap(uint32_t bits) { return __builtin_bswap32(bits); } };
+template<> struct ByteSwap<8> { static uint64_t swap(uint64_t bits) { return __builtin_bswap64(bits); } };
+
+template<typename T> inline void storeBigEndian(unsigned char *out, T value) {
+    typename UnsignedOfSize<sizeof(T)>::Type bits;
+    memcpy(&bits, &value, sizeof(T));
+#if HOST_LITTLE_ENDIAN
+    bits = ByteSwap<sizeof(T)>::swap(bits);
+#endif
+    memcpy(out, &bits, sizeof(T));
+}
+
+template<typename T> inline T loadBigEndian(const unsigned char *in) {
+    typename UnsignedOfSize<sizeof(T)>::Type bits;
+    memcpy(&bits, in, sizeof(T));
+#if HOST_LITTLE_ENDIAN
+    bits = ByteSwap<sizeof(T)>::swap(bits);
+#endif
+    T value;
+    memcpy(&value, &bits, sizeof(T));
+    return value;
+}
+
+// Signed 24-bit integers, as used by the compact location form.
+inline void storeInt24(unsigned char *out, int32_t value) {
+    out[0] = value >> 16;
+    out[1] = value >> 8;
+    out[2] = value;
+}
+
+inline int32_t loadInt24(const unsigned char *in) {
+    int32_t value = ((uint32_t)in[0] << 16) | ((uint32_t)in[1] << 8) | in[2];
+    if (value & 0x800000) {
+        value -= 0x1000000;
+    }
+    return value;
+}
+
+// Packs the low `bits` bits of value MSB-first, starting `bit` bits into out.
+// The target bits must already be zero.
+inline void storeBits(unsigned char *out, unsigned long bit, uint32_t value, uint8_t bits) {
+    out += bit / 8;
+    uint8_t shift = bit % 8;
+    while (bits > 0) {
+        uint8_t room = 8 - shift;
+        uint8_t take = bits < room ? bits : room;
+        bits -= take;
+        *out++ |= ((value >> bits) & ((1u << take) - 1)) << (room - take);
+        shift = 0;
+    }
+}
+
+// Reads back what storeBits wrote.
+inline uint32_t loadBits(const unsigned char *in, unsigned long bit, uint8_t bits) {
+    in += bit / 8;
+    uint8_t shift = bit % 8;
+    uint32_t value = 0;
+    while (bits > 0) {
+        uint8_t room = 8 - shift;
+        uint8_t take = bits < room ? bits : room;
+        bits -= take;
+        value = (value << take) | ((*in++ >> (room - take)) & ((1u << take) - 1));
+        shift = 0;
+    }
+    return value;
+}
+
+#endif
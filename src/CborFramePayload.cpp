@@ -0,0 +1,141 @@
+#include <string.h>
+
+#include "CborFramePayload.h"
+#include "ByteOrder.h"
+
+const unsigned int CborFramePayload::maxSlots;
+
+CborFramePayload::CborFramePayload(unsigned int capacity, unsigned int slots) {
+    // Slot offsets are stored in a byte.
+    this->capacity = capacity < 256 ? capacity : 256;
+    this->buffer = new unsigned char[this->capacity];
+    this->slotCapacity = slots < maxSlots ? slots : maxSlots;
+    this->slots = new Slot[this->slotCapacity];
+
+    buffer[0] = 0xA0; // Empty map
+    size = 1;
+}
+
+CborFramePayload::~CborFramePayload() {
+    delete[] buffer;
+    delete[] slots;
+}
+
+unsigned char *CborFramePayload::getBytes() {
+    return buffer;
+}
+
+unsigned int CborFramePayload::getSize() {
+    return slotCount == 0 ? 0 : size;
+}
+
+unsigned int CborFramePayload::getSlotCount() {
+    return slotCount;
+}
+
+void CborFramePayload::reset() {
+    for (unsigned int i = 0; i < slotCount; ++i) {
+        unsigned char *out = buffer + slots[i].offset;
+        if (slots[i].type == boolSlot) {
+            out[0] = 0xF4;
+        } else {
+            out[0] = slots[i].type == floatSlot ? 0xFA : 0x1A;
+            memset(out + 1, 0, 4);
+        }
+    }
+}
+
+int CborFramePayload::addFloat(const char *assetName) {
+    return addSlot(assetName, floatSlot);
+}
+
+int CborFramePayload::addInteger(const char *assetName) {
+    return addSlot(assetName, integerSlot);
+}
+
+int CborFramePayload::addBool(const char *assetName) {
+    return addSlot(assetName, boolSlot);
+}
+
+int CborFramePayload::addSlot(const char *assetName, SlotType type) {
+    unsigned int length = strlen(assetName);
+    unsigned int header = length < 24 ? 1 : 2;
+    unsigned int value = type == boolSlot ? 1 : 5;
+    if (slotCount >= slotCapacity || size + header + length + value > capacity)
+        return -1;
+
+    if (length < 24) {
+        buffer[size++] = 0x60 | length;
+    } else {
+        buffer[size++] = 0x78;
+        buffer[size++] = length;
+    }
+    memcpy(buffer + size, assetName, length);
+    size += length;
+
+    slots[slotCount].offset = size;
+    slots[slotCount].type = type;
+    if (type == boolSlot) {
+        buffer[size] = 0xF4;
+    } else {
+        buffer[size] = type == floatSlot ? 0xFA : 0x1A;
+        memset(buffer + size + 1, 0, 4);
+    }
+    size += value;
+
+    buffer[0] = 0xA0 | ++slotCount;
+    return slotCount - 1;
+}
+
+bool CborFramePayload::setFloat(int slot, float value) {
+    storeBigEndian(buffer + slots[slot].offset + 1, value);
+    return true;
+}
+
+bool CborFramePayload::setInteger(int slot, int32_t value) {
+    unsigned char *out = buffer + slots[slot].offset;
+    if (value < 0) {
+        out[0] = 0x3A;
+        storeBigEndian(out + 1, (uint32_t)(-(value + 1)));
+    } else {
+        out[0] = 0x1A;
+        storeBigEndian(out + 1, (uint32_t)value);
+    }
+    return true;
+}
+
+template<> bool CborFramePayload::set(int slot, bool value) {
+    if (slot < 0 || (unsigned int)slot >= slotCount || slots[slot].type != boolSlot)
+        return false;
+
+    buffer[slots[slot].offset] = value ? 0xF5 : 0xF4;
+    return true;
+}
+
+template<> bool CborFramePayload::set(int slot, long value) {
+    if (slot < 0 || (unsigned int)slot >= slotCount || slots[slot].type == boolSlot)
+        return false;
+
+    if (slots[slot].type == floatSlot)
+        return setFloat(slot, value);
+
+    return setInteger(slot, value);
+}
+
+template<> bool CborFramePayload::set(int slot, int value) {
+    return set(slot, (long)value);
+}
+
+template<> bool CborFramePayload::set(int slot, double value) {
+    if (slot < 0 || (unsigned int)slot >= slotCount || slots[slot].type == boolSlot)
+        return false;
+
+    if (slots[slot].type == integerSlot)
+        return setInteger(slot, (int32_t)value);
+
+    return setFloat(slot, value);
+}
+
+template<> bool CborFramePayload::set(int slot, float value) {
+    return set(slot, (double)value);
+}
@@ -0,0 +1,71 @@
+#ifndef CBOR_FRAME_PAYLOAD_H_
+#define CBOR_FRAME_PAYLOAD_H_
+
+#include "Payload.h"
+
+#include <stdint.h>
+
+// A CBOR map that is laid out once and then only has its values rewritten,
+// for telemetry that sends the same assets every cycle:
+//
+//   CborFramePayload frame;
+//   int temperature = frame.addFloat("temperature");
+//   int door = frame.addBool("door");
+//
+//   frame.set(temperature, 21.5);   // every cycle: a few byte stores
+//   frame.set(door, true);
+//   modem.send(frame);
+//
+// Every value has a fixed width so that its bytes stay at the same offset:
+// floats are always single precision (5 bytes), integers always take the
+// 4 byte argument form (5 bytes), booleans 1 byte. The frame decodes like a
+// CborPayload without timestamp or location.
+class CborFramePayload : public Payload {
+public:
+    static const unsigned int maxSlots = 23; // Map header stays 1 byte
+
+    CborFramePayload(unsigned int capacity = 51, unsigned int slots = 8);
+    ~CborFramePayload();
+    CborFramePayload(const CborFramePayload &) = delete;
+    CborFramePayload &operator=(const CborFramePayload &) = delete;
+
+    // Adds an asset to the layout, initially 0 or false. Returns its slot,
+    // or -1 if it does not fit.
+    int addFloat(const char *assetName);
+    int addInteger(const char *assetName);
+    int addBool(const char *assetName);
+
+    // Integers are stored in float slots and vice versa (truncated);
+    // booleans only go into bool slots.
+    template<typename T> bool set(int slot, T value);
+
+    unsigned int getSlotCount();
+
+    virtual unsigned char* getBytes();
+    virtual unsigned int getSize();
+
+    // Zeroes every value; the layout stays.
+    virtual void reset();
+
+private:
+    enum SlotType { floatSlot, integerSlot, boolSlot };
+
+    struct Slot {
+        uint8_t offset; // of the value's initial byte
+        uint8_t type;
+    };
+
+    unsigned char *buffer;
+    unsigned int capacity;
+    unsigned int size = 0;
+
+    Slot *slots;
+    unsigned int slotCapacity;
+    unsigned int slotCount = 0;
+
+    int addSlot(const char *assetName, SlotType type);
+    bool setFloat(int slot, float value);
+    bool setInteger(int slot, int32_t value);
+};
+
+#endif
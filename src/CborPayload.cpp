@@ -1,11 +1,20 @@
 #include <stdint.h>
+#include <string.h>
 
 #include "CborPayload.h"
 #include "GeoLocation.h"
 
+const unsigned int CborPayload::headerReserve;
+const unsigned int CborPayload::maxDepth;
+
 CborPayload::CborPayload(unsigned int capacity) {
     this->capacity = capacity;
-    this->buffer = new unsigned char[capacity];
+
+    // The smallest header is a single byte, so the assets can take up to
+    // capacity - 1 bytes after the reserve.
+    this->buffer = new unsigned char[headerReserve + capacity - 1];
+    this->output = new CborBufferSink(buffer, headerReserve + capacity - 1);
+    this->writer = new CborWriterT<CborBufferSink>(*output);
     reset();
 }
 
@@ -15,28 +24,62 @@ CborPayload::~CborPayload() {
     delete writer;
 }
 
+CborPayload::CborPayload(CborPayload &&other) : buffer(0), output(0), writer(0) {
+    *this = static_cast<CborPayload &&>(other);
+}
+
+CborPayload &CborPayload::operator=(CborPayload &&other) {
+    if (this == &other)
+        return *this;
+
+    delete[] buffer;
+    delete output;
+    delete writer;
+
+    // The writer and output only point at each other and at the buffer, so
+    // they move along as they are.
+    buffer = other.buffer;
+    output = other.output;
+    writer = other.writer;
+    hasTimestamp = other.hasTimestamp;
+    hasLocation = other.hasLocation;
+    capacity = other.capacity;
+    assetCount = other.assetCount;
+    timestamp = other.timestamp;
+    location = other.location;
+    sealed = other.sealed;
+    frameOffset = other.frameOffset;
+    frameSize = other.frameSize;
+    memcpy(remaining, other.remaining, sizeof(remaining));
+    depth = other.depth;
+
+    other.buffer = 0;
+    other.output = 0;
+    other.writer = 0;
+    return *this;
+}
+
 void CborPayload::reset() {
-    output = new CborStaticOutput(buffer, capacity);
-    writer = new CborWriter(*output);
+    unsigned char reserve[headerReserve] = { 0 };
+    output->rewind(0);
+    output->put(reserve, headerReserve, 0, 0);
     assetCount = 0;
-
-    // We're always assuming the full IoT Data Point (Tag 120)
-    // is going to be used. The real state will be represented
-    // only in getBytes().
-    writer->writeTag(120);
-    writer->writeArray(1);
-    writer->writeMap(0);
+    depth = 0;
+    sealed = false;
 }
 
 bool CborPayload::setTimestamp(uint64_t timestamp) {
     hasTimestamp = true;
     this->timestamp = timestamp;
+    sealed = false;
     return true;
 }
 
 bool CborPayload::setLocation(GeoLocation location) {
     hasLocation = true;
     this->location = location;
+    sealed = false;
+    return true;
 }
 
 template<> void CborPayload::write(bool value) {
@@ -52,15 +95,41 @@ template<> void CborPayload::write(const char *value) {
 }
 
 template<> void CborPayload::write(String value) {
-    char buffer[value.length() + 1];
-    value.toCharArray(buffer, value.length() + 1);
-    writer->writeString(buffer);
+    writer->writeString(value.c_str(), value.length());
+}
+
+template<> void CborPayload::write(short value) {
+    writer->writeInt(value);
+}
+
+template<> void CborPayload::write(unsigned short value) {
+    writer->writeInt(value);
 }
 
 template<> void CborPayload::write(int value) {
     writer->writeInt(value);
 }
 
+template<> void CborPayload::write(unsigned int value) {
+    writer->writeInt(value);
+}
+
+template<> void CborPayload::write(long value) {
+    writer->writeInt(value);
+}
+
+template<> void CborPayload::write(unsigned long value) {
+    writer->writeInt(value);
+}
+
+template<> void CborPayload::write(long long value) {
+    writer->writeInt(value);
+}
+
+template<> void CborPayload::write(unsigned long long value) {
+    writer->writeInt(value);
+}
+
 template<> void CborPayload::write(float value) {
     writer->writeFloat(value);
 }
@@ -79,75 +148,176 @@ template<> void CborPayload::write(GeoLocation location) {
     }
 }
 
-unsigned char *CborPayload::getBytes() {
-    if (assetCount == 0) {
-        return 0;
-    }
+bool CborPayload::seal() {
+    if (sealed)
+        return true;
+
+    if (assetCount == 0 || depth > 0)
+        return false;
 
     unsigned char meta = 1;
     if (hasTimestamp) meta = 2;
     if (hasLocation) meta = 3;
 
-    auto headerOutput = CborStaticOutput(buffer, capacity);
-    auto headerWriter = CborWriter(headerOutput);
-    headerWriter.writeTag(120);
-    headerWriter.writeArray(meta);
+    unsigned char header[headerReserve];
+    CborBufferSink headerOutput(header, headerReserve);
+    CborWriterT<CborBufferSink> headerWriter(headerOutput);
+    if (meta > 1) {
+        headerWriter.writeTag(120);
+        headerWriter.writeArray(meta);
+    }
     headerWriter.writeMap(assetCount);
+    if (headerOutput.hasOverflowed())
+        return false; // 65536 or more assets along with a timestamp or location
 
-    auto footerOutput = CborStaticOutput(
-        buffer + output->getSize(), capacity - output->getSize());
-    auto footerWriter = CborWriter(footerOutput);
+    unsigned int assetsEnd = output->getSize();
+    unsigned int headerSize = headerOutput.getSize();
+    frameOffset = headerReserve - headerSize;
+    memcpy(buffer + frameOffset, header, headerSize);
 
     if (hasTimestamp) {
-        footerWriter.writeTag(1); // unix timestamp
-        footerWriter.writeInt(timestamp);
+        writer->writeTag(1); // unix timestamp
+        writer->writeInt(timestamp);
     }
 
     if (hasLocation) {
-        if (!hasTimestamp) footerWriter.writeSpecial(22); // null
-        footerWriter.writeTag(103);
-        footerWriter.writeArray(location.hasAltitude() ? 3 : 2);
-        footerWriter.writeFloat(location.latitude);
-        footerWriter.writeFloat(location.longitude);
+        if (!hasTimestamp) writer->writeSpecial(22); // null
+        writer->writeTag(103);
+        writer->writeArray(location.hasAltitude() ? 3 : 2);
+        writer->writeFloat(location.latitude);
+        writer->writeFloat(location.longitude);
         if (location.hasAltitude()) {
-            footerWriter.writeFloat(location.altitude);
+            writer->writeFloat(location.altitude);
         }
     }
 
-    if (meta > 1) {
-        return buffer;
-    } else {
-        return buffer + 3;
-    }
+    bool fits = !output->hasOverflowed() && output->getSize() - frameOffset <= capacity;
+    frameSize = output->getSize() - frameOffset;
+
+    // The footer is rewritten on the next seal, after any new assets.
+    output->rewind(assetsEnd);
+    if (!fits)
+        return false;
+
+    sealed = true;
+    return true;
+}
+
+unsigned char *CborPayload::getBytes() {
+    return seal() ? buffer + frameOffset : 0;
 }
 
 unsigned int CborPayload::getSize() {
-    if (assetCount == 0) {
-        return 0;
+    return seal() ? frameSize : 0;
+}
+
+// Size of the frame seal() would make with this many assets: the map grows a
+// byte at 24 and 256 assets, and the timestamp and location come on top.
+unsigned int CborPayload::sealedSize(unsigned int assets) {
+    typedef CborWriterT<CborBufferSink> Writer;
+    unsigned char head[Writer::maxHeadSize];
+    unsigned int size = Writer::encodeHead(head, 5, (uint32_t)assets);
+    if (hasTimestamp || hasLocation) {
+        size += 2 + 1; // tag 120, array
+    }
+    if (hasTimestamp) {
+        size += 1 + Writer::encodeHead(head, 0, timestamp); // tag 1
     }
-    auto size = output->getSize();
     if (hasLocation) {
-        size += 3 + 5 + 5; // geotag, latitude, longitude
-        if (location.hasAltitude()) size += 5; // altitude
-        if (!hasTimestamp) size += 1; // null for location
+        size += (hasTimestamp ? 0 : 1) + 2 + 1 + (location.hasAltitude() ? 3 : 2) * 5;
     }
-    if (hasTimestamp) size += 6; // time tag, int
-    if (!hasTimestamp && !hasLocation) size -= 3;
+    return size + output->getSize() - headerReserve;
+}
 
-    return size;
+bool CborPayload::commitAsset(unsigned int rollback) {
+    unsigned int assets = assetCount + (depth == 0 ? 1 : 0);
+    if (output->hasOverflowed() || sealedSize(assets) > capacity) {
+        output->rewind(rollback);
+        return false;
+    }
+    sealed = false;
+
+    if (depth == 0) {
+        assetCount++;
+    } else if (--remaining[depth - 1] == 0) {
+        depth--;
+    }
+    return true;
 }
 
 template<typename T> bool CborPayload::set(char *assetName, T value) {
+    unsigned int rollback = output->getSize();
     writer->writeString(assetName);
     write(value);
-    assetCount++;
+    return commitAsset(rollback);
+}
+
+template<typename T> bool CborPayload::set(char *assetName, const T *values, unsigned int count) {
+    unsigned int rollback = output->getSize();
+    writer->writeString(assetName);
+    writer->writeArray(count);
+    for (unsigned int i = 0; i < count; ++i) {
+        write(values[i]);
+    }
+    return commitAsset(rollback);
+}
+
+bool CborPayload::setBytes(char *assetName, const unsigned char *data, unsigned int size) {
+    unsigned int rollback = output->getSize();
+    writer->writeString(assetName);
+    writer->writeBytes(data, size);
+    return commitAsset(rollback);
+}
+
+bool CborPayload::setObject(char *assetName, unsigned int count) {
+    if (depth == maxDepth && count > 0)
+        return false;
+
+    unsigned int rollback = output->getSize();
+    writer->writeString(assetName);
+    writer->writeMap(count);
+    if (!commitAsset(rollback))
+        return false;
+
+    if (count > 0) {
+        remaining[depth++] = count;
+    }
+    return true;
+}
+
+bool CborPayload::setCompact(char *assetName, GeoLocation location) {
+    unsigned char compact[GeoLocation::compactSizeWithAltitude];
+    unsigned int rollback = output->getSize();
+    writer->writeString(assetName);
+    writer->writeTag(GeoLocation::compactTag);
+    writer->writeBytes(compact, location.toCompact(compact));
+    return commitAsset(rollback);
 }
 
 template bool CborPayload::set(char *assetName, bool value);
 template bool CborPayload::set(char *assetName, char *value);
 template bool CborPayload::set(char *assetName, const char *value);
 template bool CborPayload::set(char *assetName, String value);
+template bool CborPayload::set(char *assetName, short value);
+template bool CborPayload::set(char *assetName, unsigned short value);
 template bool CborPayload::set(char *assetName, int value);
+template bool CborPayload::set(char *assetName, unsigned int value);
+template bool CborPayload::set(char *assetName, long value);
+template bool CborPayload::set(char *assetName, unsigned long value);
+template bool CborPayload::set(char *assetName, long long value);
+template bool CborPayload::set(char *assetName, unsigned long long value);
 template bool CborPayload::set(char *assetName, float value);
 template bool CborPayload::set(char *assetName, double value);
 template bool CborPayload::set(char *assetName, GeoLocation value);
+
+template bool CborPayload::set(char *assetName, const bool *values, unsigned int count);
+template bool CborPayload::set(char *assetName, const short *values, unsigned int count);
+template bool CborPayload::set(char *assetName, const unsigned short *values, unsigned int count);
+template bool CborPayload::set(char *assetName, const int *values, unsigned int count);
+template bool CborPayload::set(char *assetName, const unsigned int *values, unsigned int count);
+template bool CborPayload::set(char *assetName, const long *values, unsigned int count);
+template bool CborPayload::set(char *assetName, const unsigned long *values, unsigned int count);
+template bool CborPayload::set(char *assetName, const long long *values, unsigned int count);
+template bool CborPayload::set(char *assetName, const unsigned long long *values, unsigned int count);
+template bool CborPayload::set(char *assetName, const float *values, unsigned int count);
+template bool CborPayload::set(char *assetName, const double *values, unsigned int count);
@@ -8,24 +8,69 @@
 #include <string.h>
 #include <stdint.h>
 
+// Assets are encoded as they are set, after room for the widest header
+// (tag 120, array, map of up to 65535 assets). seal() writes the real header
+// in front of them and the timestamp/location after them, once; getBytes()
+// and getSize() seal on demand and then only return the cached frame.
+// Setting anything unseals it again.
 class CborPayload : public Payload {
 public:
     CborPayload(unsigned int capacity = 51); // Lowest LoRa payload length.
     ~CborPayload();
 
+    // Moving hands the frame over; the payload moved from can only be
+    // destroyed or assigned to. Copies are not allowed.
+    CborPayload(CborPayload &&other);
+    CborPayload &operator=(CborPayload &&other);
+    CborPayload(const CborPayload &) = delete;
+    CborPayload &operator=(const CborPayload &) = delete;
+
+    // Returns false, leaving the payload as it was, if the asset does not fit.
     template<typename T> bool set(char *assetName, T value);
 
+    // An array of numbers, e.g. the x, y and z of an accelerometer.
+    template<typename T> bool set(char *assetName, const T *values, unsigned int count);
+
+    // A byte string, for raw sensor data.
+    bool setBytes(char *assetName, const unsigned char *data, unsigned int size);
+
+    // Starts a nested object under assetName. The next `count` set() calls
+    // name its members; then the payload continues at the outer level:
+    //
+    //   payload.setObject("acceleration", 3);
+    //   payload.set("x", x);
+    //   payload.set("y", y);
+    //   payload.set("z", z);
+    //
+    // Objects nest up to maxDepth deep. A frame with an unfinished object
+    // does not seal.
+    bool setObject(char *assetName, unsigned int count);
+
+    // The 6 or 8 byte compact form of the location in its own tag
+    // (GeoLocation::compactTag) instead of an array of floats in tag 103.
+    bool setCompact(char *assetName, GeoLocation location);
+
     bool setTimestamp(uint64_t timestamp);
     bool setLocation(GeoLocation location);
 
+    // Finalizes the frame. Returns false if there are no assets, if the
+    // frame with its header and metadata exceeds the capacity, or if the
+    // header does not fit headerReserve (65536 or more assets with a
+    // timestamp or location).
+    bool seal();
+
     virtual unsigned char* getBytes();
     virtual unsigned int getSize();
     virtual void reset();
 
+    static const unsigned int maxDepth = 4;
+
 private:
+    static const unsigned int headerReserve = 2 + 1 + 3; // tag 120, array(3), map(65535)
+
     unsigned char *buffer;
-    CborStaticOutput *output;
-    CborWriter *writer;
+    CborBufferSink *output;
+    CborWriterT<CborBufferSink> *writer;
 
     bool hasTimestamp = false;
     bool hasLocation = false;
@@ -34,7 +79,17 @@ private:
     uint64_t timestamp;
     GeoLocation location;
 
+    bool sealed = false;
+    unsigned int frameOffset = 0;
+    unsigned int frameSize = 0;
+
+    // Members still expected by each open object, innermost last.
+    unsigned int remaining[maxDepth];
+    unsigned int depth = 0;
+
     template<typename T> void write(T value);
+    unsigned int sealedSize(unsigned int assets);
+    bool commitAsset(unsigned int rollback);
 };
 
 #endif
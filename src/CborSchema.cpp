@@ -0,0 +1,124 @@
+#include <string.h>
+
+#include "CborSchema.h"
+#include "Library-Arduino-Cbor/CborCursor.h"
+
+const unsigned int CborSchema::maxFields;
+
+template<typename T> static void store(unsigned char *out, T value) {
+    memcpy(out, &value, sizeof(T));
+}
+
+static bool storeUnsigned(unsigned char *out, uint8_t size, uint64_t value) {
+    if (size < 8 && value >> (size * 8) != 0)
+        return false;
+
+    switch (size) {
+        case 1: store(out, (uint8_t)value); break;
+        case 2: store(out, (uint16_t)value); break;
+        case 4: store(out, (uint32_t)value); break;
+        case 8: store(out, value); break;
+        default: return false;
+    }
+    return true;
+}
+
+static bool storeSigned(unsigned char *out, uint8_t size, int64_t value) {
+    if (size < 8) {
+        int64_t max = ((int64_t)1 << (size * 8 - 1)) - 1;
+        if (value > max || value < -max - 1)
+            return false;
+    }
+
+    switch (size) {
+        case 1: store(out, (int8_t)value); break;
+        case 2: store(out, (int16_t)value); break;
+        case 4: store(out, (int32_t)value); break;
+        case 8: store(out, value); break;
+        default: return false;
+    }
+    return true;
+}
+
+static bool storeField(const CborField &field, unsigned char *out, CborToken &value) {
+    switch (field.kind) {
+        case CBOR_FIELD_BOOL:
+            if (!value.isBool() && !value.isInteger())
+                return false;
+            store(out, value.asBool());
+            return true;
+
+        case CBOR_FIELD_UNSIGNED:
+            if (value.type != CBOR_UNSIGNED)
+                return false;
+            return storeUnsigned(out, field.size, value.value);
+
+        case CBOR_FIELD_SIGNED:
+            if (!value.isInteger() || value.value > 0x7FFFFFFFFFFFFFFFULL)
+                return false;
+            return storeSigned(out, field.size, value.asLong());
+
+        case CBOR_FIELD_FLOAT:
+            if (value.type != CBOR_FLOAT && !value.isInteger())
+                return false;
+            if (field.size == sizeof(float)) {
+                store(out, (float)value.asNumber());
+            } else {
+                store(out, value.asNumber());
+            }
+            return true;
+
+        case CBOR_FIELD_TEXT:
+            if (value.type != CBOR_STRING)
+                return false;
+            value.copyTo(reinterpret_cast<char *>(out), field.size);
+            return true;
+    }
+    return false;
+}
+
+CborSchema::CborSchema(const CborField *fields, unsigned int count) {
+    this->fields = fields;
+    this->count = count < maxFields ? count : maxFields;
+}
+
+uint32_t CborSchema::getPresent() {
+    return present;
+}
+
+bool CborSchema::isPresent(unsigned int field) {
+    return field < count && (present & ((uint32_t)1 << field)) != 0;
+}
+
+bool CborSchema::decodeInto(const unsigned char *bytes, unsigned int size, unsigned char *target) {
+    present = 0;
+
+    CborCursor cursor(bytes, size);
+    CborToken map;
+    if (!cursor.next(map) || map.type != CBOR_MAP)
+        return false;
+
+    for (uint64_t i = 0; map.indefinite || i < map.value; ++i) {
+        CborToken key, value;
+        if (!cursor.next(key))
+            return false;
+        if (key.type == CBOR_BREAK && map.indefinite)
+            return true;
+        if (!cursor.skip(key) || !cursor.next(value) || value.type == CBOR_BREAK)
+            return false;
+
+        unsigned int index = count;
+        if (key.type == CBOR_STRING) {
+            for (index = 0; index < count; ++index) {
+                if (key.equals(fields[index].key)) break;
+            }
+        }
+
+        if (index < count && storeField(fields[index], target + fields[index].offset, value)) {
+            present |= (uint32_t)1 << index;
+        } else if (!cursor.skip(value)) {
+            return false;
+        }
+    }
+    return cursor.isValid();
+}
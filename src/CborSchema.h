@@ -0,0 +1,99 @@
+#ifndef CBOR_SCHEMA_H_
+#define CBOR_SCHEMA_H_
+
+#include "Payload.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Decodes a CBOR map from a downlink straight into a struct, in one pass and
+// without allocating:
+//
+//   struct Config { uint16_t interval; bool led; float threshold; char name[12]; };
+//
+//   const CborField configFields[] = {
+//       CBOR_FIELD("interval", Config, interval),
+//       CBOR_FIELD("led", Config, led),
+//       CBOR_FIELD("threshold", Config, threshold),
+//       CBOR_FIELD("name", Config, name),
+//   };
+//   CborSchema configSchema(configFields, 4);
+//
+//   void callback(BinaryPayload &payload, LoRaOptions &options) {
+//       if (configSchema.decode(payload, config) && configSchema.isPresent(0)) ...
+//   }
+//
+// The field type follows from the member. Keys that are not in the schema
+// are skipped; values of the wrong type or out of range for their field
+// leave the field untouched and it does not count as present. Integers fill
+// float fields, and integers or booleans fill bool fields. Text is truncated
+// to the array and always terminated.
+
+enum CborFieldKind { CBOR_FIELD_BOOL, CBOR_FIELD_UNSIGNED, CBOR_FIELD_SIGNED, CBOR_FIELD_FLOAT, CBOR_FIELD_TEXT };
+
+struct CborField {
+    const char *key;
+    uint16_t offset;
+    uint8_t kind;
+    uint8_t size;
+};
+
+template<typename T> struct CborFieldType;
+template<> struct CborFieldType<bool> { static const uint8_t kind = CBOR_FIELD_BOOL; };
+template<> struct CborFieldType<float> { static const uint8_t kind = CBOR_FIELD_FLOAT; };
+template<> struct CborFieldType<double> { static const uint8_t kind = CBOR_FIELD_FLOAT; };
+// Fundamental types, so that every intN_t alias resolves to one of them.
+template<> struct CborFieldType<signed char> { static const uint8_t kind = CBOR_FIELD_SIGNED; };
+template<> struct CborFieldType<unsigned char> { static const uint8_t kind = CBOR_FIELD_UNSIGNED; };
+template<> struct CborFieldType<short> { static const uint8_t kind = CBOR_FIELD_SIGNED; };
+template<> struct CborFieldType<unsigned short> { static const uint8_t kind = CBOR_FIELD_UNSIGNED; };
+template<> struct CborFieldType<int> { static const uint8_t kind = CBOR_FIELD_SIGNED; };
+template<> struct CborFieldType<unsigned int> { static const uint8_t kind = CBOR_FIELD_UNSIGNED; };
+template<> struct CborFieldType<long> { static const uint8_t kind = CBOR_FIELD_SIGNED; };
+template<> struct CborFieldType<unsigned long> { static const uint8_t kind = CBOR_FIELD_UNSIGNED; };
+template<> struct CborFieldType<long long> { static const uint8_t kind = CBOR_FIELD_SIGNED; };
+template<> struct CborFieldType<unsigned long long> { static const uint8_t kind = CBOR_FIELD_UNSIGNED; };
+template<unsigned int N> struct CborFieldType<char[N]> { static const uint8_t kind = CBOR_FIELD_TEXT; };
+
+// offsetof is only defined for standard-layout structs. AVR has no
+// <type_traits>, so this asks the compiler directly, as std::is_standard_layout
+// does.
+template<typename S> constexpr uint16_t cborFieldOffset(size_t offset) {
+    static_assert(__is_standard_layout(S), "CborSchema needs a plain struct.");
+    return offset;
+}
+
+// A constant initializer, so a field table needs no code or stack to build
+// and can stay in flash.
+#define CBOR_FIELD(key, S, member) \
+    { key, cborFieldOffset<S>(offsetof(S, member)), CborFieldType<decltype(S::member)>::kind, sizeof(S::member) }
+
+class CborSchema {
+public:
+    static const unsigned int maxFields = 32; // One presence bit each
+
+    CborSchema(const CborField *fields, unsigned int count);
+
+    // Returns false if the input is not a well-formed CBOR map. Fields
+    // decoded before the error have already been written.
+    template<typename S> bool decode(const unsigned char *bytes, unsigned int size, S &target) {
+        return decodeInto(bytes, size, reinterpret_cast<unsigned char *>(&target));
+    }
+
+    template<typename S> bool decode(Payload &payload, S &target) {
+        return decode(payload.getBytes(), payload.getSize(), target);
+    }
+
+    // Fields written by the last decode(), one bit per field index.
+    uint32_t getPresent();
+    bool isPresent(unsigned int field);
+
+private:
+    const CborField *fields;
+    unsigned int count;
+    uint32_t present = 0;
+
+    bool decodeInto(const unsigned char *bytes, unsigned int size, unsigned char *target);
+};
+
+#endif
@@ -0,0 +1,90 @@
+#include <string.h>
+
+#include "CompressedPayload.h"
+
+const unsigned char CompressedPayload::storedFormat;
+const unsigned char CompressedPayload::lzssFormat;
+
+CompressedPayload::CompressedPayload(unsigned int capacity, const unsigned char *dictionary, unsigned int dictionarySize)
+    : encoder(dictionary, dictionarySize) {
+    this->capacity = capacity;
+    this->buffer = new unsigned char[capacity];
+}
+
+CompressedPayload::~CompressedPayload() {
+    delete[] buffer;
+}
+
+unsigned char *CompressedPayload::getBytes() {
+    return buffer;
+}
+
+unsigned int CompressedPayload::getSize() {
+    return size;
+}
+
+void CompressedPayload::reset() {
+    size = 0;
+}
+
+void CompressedPayload::begin() {
+    size = 0;
+    written = 0;
+    buffer[0] = lzssFormat;
+    encoder.begin(buffer + 1, capacity - 1);
+}
+
+bool CompressedPayload::write(const unsigned char *data, unsigned int length) {
+    written += length;
+    return encoder.write(data, length);
+}
+
+bool CompressedPayload::write(const char *text) {
+    return write(reinterpret_cast<const unsigned char *>(text), strlen(text));
+}
+
+bool CompressedPayload::finish() {
+    unsigned int length = encoder.finish();
+    if (length == 0 && written > 0)
+        return false;
+
+    size = 1 + length;
+    return true;
+}
+
+bool CompressedPayload::compress(Payload &payload) {
+    unsigned char *bytes = payload.getBytes();
+    unsigned int length = payload.getSize();
+
+    begin();
+    bool compressed = write(bytes, length) && finish();
+    if (compressed && size <= length) {
+        return true;
+    }
+
+    if (1 + length > capacity) {
+        size = 0;
+        return false;
+    }
+    buffer[0] = storedFormat;
+    memcpy(buffer + 1, bytes, length);
+    size = 1 + length;
+    return true;
+}
+
+unsigned int CompressedPayload::decode(const unsigned char *in, unsigned int length, unsigned char *out, unsigned int capacity,
+                                       const unsigned char *dictionary, unsigned int dictionarySize) {
+    if (length == 0)
+        return 0;
+
+    if (in[0] == storedFormat) {
+        if (length - 1 > capacity)
+            return 0;
+        memcpy(out, in + 1, length - 1);
+        return length - 1;
+    }
+    if (in[0] == lzssFormat) {
+        return lzssDecode(in + 1, length - 1, out, capacity, dictionary, dictionarySize);
+    }
+    return 0;
+}
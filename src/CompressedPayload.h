@@ -0,0 +1,52 @@
+#ifndef COMPRESSED_PAYLOAD_H_
+#define COMPRESSED_PAYLOAD_H_
+
+#include "Payload.h"
+#include "Lzss.h"
+
+// Optional compression stage between a payload and LoRaModem::send, for
+// frames that carry a lot of text:
+//
+//   CompressedPayload compressed;
+//   if (compressed.compress(payload)) {
+//       modem.send(compressed);
+//   }
+//
+// The first byte tells what follows: storedFormat for the frame as is (when
+// compressing would not make it smaller), lzssFormat for an LZSS stream
+// (see Lzss.h). Data can also be streamed in directly with begin(), write()
+// and finish(). CompressedPayload::decode expands a frame on the backend.
+class CompressedPayload : public Payload {
+public:
+    static const unsigned char storedFormat = 0;
+    static const unsigned char lzssFormat = 1;
+
+    CompressedPayload(unsigned int capacity = 51, const unsigned char *dictionary = 0, unsigned int dictionarySize = 0);
+    ~CompressedPayload();
+    CompressedPayload(const CompressedPayload &) = delete;
+    CompressedPayload &operator=(const CompressedPayload &) = delete;
+
+    bool compress(Payload &payload);
+
+    void begin();
+    bool write(const unsigned char *data, unsigned int length);
+    bool write(const char *text);
+    bool finish();
+
+    virtual unsigned char* getBytes();
+    virtual unsigned int getSize();
+    virtual void reset();
+
+    // Returns the size written to out, or 0 on malformed input.
+    static unsigned int decode(const unsigned char *in, unsigned int length, unsigned char *out, unsigned int capacity,
+                               const unsigned char *dictionary = 0, unsigned int dictionarySize = 0);
+
+private:
+    LzssEncoder encoder;
+    unsigned char *buffer;
+    unsigned int capacity;
+    unsigned int size = 0;
+    unsigned int written = 0;
+};
+
+#endif
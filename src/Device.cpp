@@ -1,7 +1,7 @@
 #include "Device.h"
 #include "LoRaOptions.h"
-#include "CborPayload.h"
 #include "BinaryPayload.h"
+#include "PayloadView.h"
 
 #include <string.h>
 
@@ -17,24 +17,20 @@ Options Device<Options>::getOptions() {
 
 template<class Options>
 bool Device<Options>::send(char *str) {
-    auto payload = BinaryPayload(reinterpret_cast<unsigned char *>(str), strlen(str));
+    PayloadView payload(str);
     return send(payload);
 }
 
 template<class Options>
-bool Device<Options>::send(Payload &payload, Options &options) {
-    Options previousOptions = getOptions();
-    setOptions(options);
-    send(payload);
-    setOptions(previousOptions);
+bool Device<Options>::send(const unsigned char *bytes, unsigned int size) {
+    PayloadView payload(bytes, size);
+    return send(payload);
 }
 
 template<class Options>
-bool Device<Options>::send(char *payload, Options &options) {
-    Options previousOptions = getOptions();
-    setOptions(options);
-    send(payload);
-    setOptions(previousOptions);
+bool Device<Options>::send(char *str, Options &options) {
+    PayloadView payload(str);
+    return send(payload, options);
 }
 
 template<class Options>
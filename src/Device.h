@@ -12,8 +12,17 @@ public:
     virtual Options getOptions();
 
     virtual bool send(Payload &payload) = 0;
+
+    // Sends the segments back to back as one uplink, e.g. a status header
+    // and the application data, without joining them in a buffer first.
+    virtual bool send(Payload *const *segments, unsigned int count) = 0;
+
     virtual bool send(char *str);
-    virtual bool send(Payload &payload, Options &options);
+    virtual bool send(const unsigned char *bytes, unsigned int size);
+
+    // Sends with other options for this call only; the device's own options
+    // are neither copied nor changed.
+    virtual bool send(Payload &payload, Options &options) = 0;
     virtual bool send(char *str, Options &options);
 
     virtual void setDownlinkCallback(void (*callback)(BinaryPayload &payload, Options &options));
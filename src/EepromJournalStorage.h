@@ -0,0 +1,46 @@
+#ifndef EEPROM_JOURNAL_STORAGE_H_
+#define EEPROM_JOURNAL_STORAGE_H_
+
+#include <EEPROM.h>
+
+#include "JournalStorage.h"
+
+// Keeps a journal or frame counters in the EEPROM of AVR boards such as the
+// Sodaq Mbili. Bytes that already hold the value are not written again.
+// Boards without EEPROM.h need a JournalStorage of their own, e.g. over flash.
+//
+//   EepromJournalStorage storage;                // all of the EEPROM
+//   EepromJournalStorage counterStorage(0, 200); // the first 200 bytes
+//   EepromJournalStorage journalStorage(200);    // the rest
+class EepromJournalStorage : public JournalStorage {
+public:
+    EepromJournalStorage(unsigned int offset = 0, unsigned int size = 0) : offset(offset), size(size) { }
+
+    virtual unsigned long getSize() {
+        return size > 0 ? size : EEPROM.length() - offset;
+    }
+
+    virtual bool read(unsigned long address, unsigned char *bytes, unsigned int length) {
+        if (address + length > getSize())
+            return false;
+        for (unsigned int i = 0; i < length; ++i) {
+            bytes[i] = EEPROM.read(offset + address + i);
+        }
+        return true;
+    }
+
+    virtual bool write(unsigned long address, const unsigned char *bytes, unsigned int length) {
+        if (address + length > getSize())
+            return false;
+        for (unsigned int i = 0; i < length; ++i) {
+            EEPROM.update(offset + address + i, bytes[i]);
+        }
+        return true;
+    }
+
+private:
+    unsigned int offset;
+    unsigned int size;
+};
+
+#endif
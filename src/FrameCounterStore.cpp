@@ -0,0 +1,106 @@
+#include "FrameCounterStore.h"
+#include "ByteOrder.h"
+
+const unsigned int FrameCounterStore::slotSize;
+
+// Slot: marker, uplink counter, downlink counter (4 bytes each, big-endian),
+// crc over the rest.
+static const unsigned char slotMarker = 0x5C;
+
+FrameCounterStore::FrameCounterStore(JournalStorage &storage, uint32_t stride) : storage(storage) {
+    this->stride = stride;
+}
+
+void FrameCounterStore::setStride(uint32_t stride) {
+    this->stride = stride;
+}
+
+uint32_t FrameCounterStore::getStride() {
+    return stride;
+}
+
+bool FrameCounterStore::hasCheckpoint() {
+    return found;
+}
+
+bool FrameCounterStore::begin() {
+    unsigned long size = storage.getSize();
+    slots = (size > 0xFFFF ? 0xFFFF : size) / slotSize;
+    next = 0;
+    found = false;
+    if (slots == 0)
+        return false;
+
+    for (unsigned int slot = 0; slot < slots; ++slot) {
+        unsigned char bytes[slotSize];
+        if (!storage.read((unsigned long)slot * slotSize, bytes, slotSize))
+            return false;
+        if (bytes[0] != slotMarker || journalCrc(0, bytes, slotSize - 1) != bytes[slotSize - 1])
+            continue;
+
+        // Both counters only go up, so the newest checkpoint is the highest.
+        uint32_t slotUp = loadBigEndian<uint32_t>(bytes + 1);
+        uint32_t slotDown = loadBigEndian<uint32_t>(bytes + 5);
+        if (!found || slotUp > up || (slotUp == up && slotDown > down)) {
+            found = true;
+            up = slotUp;
+            down = slotDown;
+            next = slot + 1 < slots ? slot + 1 : 0;
+        }
+    }
+    return true;
+}
+
+bool FrameCounterStore::restore(uint32_t &up, uint32_t &down) {
+    if (!found)
+        return false;
+
+    // Saturate rather than wrap around to counters the network has seen.
+    // The downlink counter is the network server's; it was checkpointed
+    // when it last moved, so it continues exactly where it was.
+    up = this->up > 0xFFFFFFFF - stride ? 0xFFFFFFFF : this->up + stride;
+    down = this->down;
+    return save(up, down);
+}
+
+bool FrameCounterStore::update(uint32_t up, uint32_t down) {
+    if (found && (up < this->up || down < this->down)) {
+        // A new session: the old checkpoints would look newer than this one.
+        if (!clear())
+            return false;
+    } else if (found && up - this->up < stride && down == this->down) {
+        return true;
+    }
+    return save(up, down);
+}
+
+bool FrameCounterStore::save(uint32_t up, uint32_t down) {
+    if (slots == 0)
+        return false;
+
+    unsigned char bytes[slotSize] = { slotMarker };
+    storeBigEndian(bytes + 1, up);
+    storeBigEndian(bytes + 5, down);
+    bytes[slotSize - 1] = journalCrc(0, bytes, slotSize - 1);
+    if (!storage.write((unsigned long)next * slotSize, bytes, slotSize))
+        return false;
+
+    found = true;
+    this->up = up;
+    this->down = down;
+    next = next + 1 < slots ? next + 1 : 0;
+    return true;
+}
+
+bool FrameCounterStore::clear() {
+    unsigned char cleared = 0;
+    for (unsigned int slot = 0; slot < slots; ++slot) {
+        if (!storage.write((unsigned long)slot * slotSize, &cleared, 1))
+            return false;
+    }
+    found = false;
+    next = 0;
+    up = 0;
+    down = 0;
+    return true;
+}
@@ -0,0 +1,71 @@
+#ifndef FRAME_COUNTER_STORE_H_
+#define FRAME_COUNTER_STORE_H_
+
+#include "JournalStorage.h"
+
+#include <stdint.h>
+
+// Checkpoints the uplink and downlink frame counters of an ABP session, so
+// that after a power loss the device continues above every counter it
+// used, instead of being rejected by the network server:
+//
+//   FrameCounterStore counters(storage, 100);
+//   modem.setFrameCounterStore(counters);
+//   modem.init(abpCredentials);
+//
+// The uplink counter is checkpointed only once it has moved `stride` past
+// the previous checkpoint. Restoring continues at the checkpoint plus
+// stride, which is above anything used since, so at most `stride` uplink
+// counter values are skipped per reset. A larger stride means fewer writes.
+// The downlink counter belongs to the network server: skipping ahead would
+// make the modem reject its next downlinks, so it is checkpointed whenever
+// a downlink moved it and restored as it was.
+//
+// Checkpoints go round the storage in 10-byte slots, each written in turn,
+// so the writes are spread over all of it. The newest slot holds the
+// highest counters; a slot whose write was interrupted fails its CRC and
+// the previous one is used.
+class FrameCounterStore {
+public:
+    static const unsigned int slotSize = 10;
+
+    FrameCounterStore(JournalStorage &storage, uint32_t stride = 100);
+
+    // Finds the newest checkpoint. Returns false if the storage cannot be
+    // read or holds less than one slot.
+    bool begin();
+    bool hasCheckpoint();
+
+    // Counters to continue with after a reset: the uplink counter of the
+    // checkpoint plus stride, and its downlink counter. They are
+    // checkpointed themselves, so resets in a row keep moving up.
+    // Returns false if there is no checkpoint or it cannot be written.
+    bool restore(uint32_t &up, uint32_t &down);
+
+    // Call with the modem's counters after every uplink. Writes a checkpoint
+    // when the uplink counter is `stride` or more past the last one, when the
+    // downlink counter changed, or when the counters went down, as they do
+    // in a new session.
+    bool update(uint32_t up, uint32_t down);
+
+    // Writes a checkpoint unconditionally.
+    bool save(uint32_t up, uint32_t down);
+
+    // Forgets all checkpoints, e.g. for a new session with counters at 0.
+    bool clear();
+
+    void setStride(uint32_t stride);
+    uint32_t getStride();
+
+private:
+    JournalStorage &storage;
+    uint32_t stride;
+
+    unsigned int slots = 0;
+    unsigned int next = 0; // Slot for the next checkpoint
+    bool found = false;
+    uint32_t up = 0;
+    uint32_t down = 0;
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include "GeoLocation.h"
+#include "ByteOrder.h"
 
 GeoLocation::GeoLocation() {
 
@@ -22,3 +23,64 @@ GeoLocation::GeoLocation(float latitude, float longitude)
 bool GeoLocation::hasAltitude() {
     return isAltitudeSet;
 }
+
+const unsigned int GeoLocation::compactSize;
+const unsigned int GeoLocation::compactSizeWithAltitude;
+const uint32_t GeoLocation::compactTag;
+
+static const float latitudeScale = 8388607 / 90.0f;
+static const float longitudeScale = 8388607 / 180.0f;
+
+static int32_t roundClamped(float value, float limit) {
+    if (value > limit) value = limit;
+    if (value < -limit) value = -limit;
+    return (int32_t)(value + (value < 0 ? -0.5f : 0.5f));
+}
+
+int32_t GeoLocation::getCompactLatitude() {
+    return roundClamped(latitude * latitudeScale, 8388607);
+}
+
+int32_t GeoLocation::getCompactLongitude() {
+    return roundClamped(longitude * longitudeScale, 8388607);
+}
+
+int16_t GeoLocation::getCompactAltitude() {
+    return roundClamped(altitude, 32767);
+}
+
+GeoLocation GeoLocation::fromCompact(int32_t latitude, int32_t longitude) {
+    return GeoLocation(latitude / latitudeScale, longitude / longitudeScale);
+}
+
+GeoLocation GeoLocation::fromCompact(int32_t latitude, int32_t longitude, int16_t altitude) {
+    return GeoLocation(latitude / latitudeScale, longitude / longitudeScale, altitude);
+}
+
+unsigned int GeoLocation::getCompactSize() {
+    return isAltitudeSet ? compactSizeWithAltitude : compactSize;
+}
+
+unsigned int GeoLocation::toCompact(unsigned char *out) {
+    storeInt24(out, getCompactLatitude());
+    storeInt24(out + 3, getCompactLongitude());
+    if (isAltitudeSet) {
+        int16_t meters = getCompactAltitude();
+        out[6] = meters >> 8;
+        out[7] = meters;
+    }
+    return getCompactSize();
+}
+
+bool GeoLocation::fromCompact(const unsigned char *in, unsigned int length, GeoLocation &location) {
+    if (length != compactSize && length != compactSizeWithAltitude) {
+        return false;
+    }
+
+    if (length == compactSizeWithAltitude) {
+        location = fromCompact(loadInt24(in), loadInt24(in + 3), (int16_t)(((uint16_t)in[6] << 8) | in[7]));
+    } else {
+        location = fromCompact(loadInt24(in), loadInt24(in + 3));
+    }
+    return true;
+}
@@ -1,6 +1,8 @@
 #ifndef GEO_LOCATION_H_
 #define GEO_LOCATION_H_
 
+#include <stdint.h>
+
 class GeoLocation {
 
 public:
@@ -11,6 +13,28 @@ public:
 
     bool hasAltitude();
 
+    // Compact fixed-point form, big-endian: 24-bit latitude and longitude
+    // (about 1.2 m and 2.4 m resolution) followed, if set, by a 16-bit
+    // altitude in whole meters.
+    static const unsigned int compactSize = 6;
+    static const unsigned int compactSizeWithAltitude = 8;
+
+    // CBOR tag around the compact form as a byte string. Tag 103 stays the
+    // standard array of numbers; this one is the SDK's own, from the first
+    // come first served range, so decoders that only know 103 skip it.
+    static const uint32_t compactTag = 32871;
+
+    unsigned int getCompactSize();
+    unsigned int toCompact(unsigned char *out);
+    static bool fromCompact(const unsigned char *in, unsigned int length, GeoLocation &location);
+
+    // The same fixed-point units as integers, for codecs that build on them.
+    int32_t getCompactLatitude();
+    int32_t getCompactLongitude();
+    int16_t getCompactAltitude();
+    static GeoLocation fromCompact(int32_t latitude, int32_t longitude);
+    static GeoLocation fromCompact(int32_t latitude, int32_t longitude, int16_t altitude);
+
     float latitude = 0;
     float longitude = 0;
     float altitude = 0;
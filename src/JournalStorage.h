@@ -0,0 +1,54 @@
+#ifndef JOURNAL_STORAGE_H_
+#define JOURNAL_STORAGE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+// Storage that survives a reset, such as EEPROM, flash or a file on the host,
+// for UplinkJournal and FrameCounterStore. Addresses run from 0 to
+// getSize() - 1; at most 64 KiB is used.
+class JournalStorage {
+public:
+    virtual unsigned long getSize() = 0;
+    virtual bool read(unsigned long address, unsigned char *bytes, unsigned int length) = 0;
+    virtual bool write(unsigned long address, const unsigned char *bytes, unsigned int length) = 0;
+};
+
+// CRC-8 (polynomial 0x07) that guards the records kept in such storage.
+inline uint8_t journalCrc(uint8_t crc, const unsigned char *bytes, unsigned int length) {
+    while (length--) {
+        crc ^= *bytes++;
+        for (uint8_t bit = 0; bit < 8; ++bit) {
+            crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+// Keeps the records in RAM, e.g. in memory that survives a deep sleep.
+class MemoryJournalStorage : public JournalStorage {
+public:
+    MemoryJournalStorage(unsigned char *bytes, unsigned long size) : bytes(bytes), size(size) { }
+
+    virtual unsigned long getSize() { return size; }
+
+    virtual bool read(unsigned long address, unsigned char *out, unsigned int length) {
+        if (address + length > size)
+            return false;
+        memcpy(out, bytes + address, length);
+        return true;
+    }
+
+    virtual bool write(unsigned long address, const unsigned char *in, unsigned int length) {
+        if (address + length > size)
+            return false;
+        memcpy(bytes + address, in, length);
+        return true;
+    }
+
+private:
+    unsigned char *bytes;
+    unsigned long size;
+};
+
+#endif
@@ -0,0 +1,246 @@
+#include <string.h>
+#include <math.h>
+
+#include "CborCursor.h"
+#include "../ByteOrder.h"
+
+const unsigned int CborCursor::maxDepth;
+
+// Spelled out: avr-libc only defines INT64_MAX and friends for C++ with
+// __STDC_LIMIT_MACROS.
+static const int64_t longMax = 0x7FFFFFFFFFFFFFFFLL;
+static const int64_t longMin = -longMax - 1;
+static const int32_t intMax = 0x7FFFFFFFL;
+static const int32_t intMin = -intMax - 1;
+
+static double halfToDouble(uint16_t half) {
+    int exponent = (half >> 10) & 0x1F;
+    int mantissa = half & 0x3FF;
+    double value;
+    if (exponent == 0) {
+        value = ldexp(mantissa, -24);
+    } else if (exponent == 31) {
+        value = mantissa == 0 ? INFINITY : NAN;
+    } else {
+        value = ldexp(mantissa + 1024, exponent - 25);
+    }
+    return (half & 0x8000) ? -value : value;
+}
+
+// Where double is only 4 bytes (AVR) the value is rebuilt from its fields.
+static double doubleFromBits(uint64_t bits) {
+    if (sizeof(double) == 8) {
+        double value;
+        memcpy(&value, &bits, sizeof(double));
+        return value;
+    }
+
+    int exponent = (bits >> 52) & 0x7FF;
+    uint64_t mantissa = bits & 0xFFFFFFFFFFFFFULL;
+    double value;
+    if (exponent == 0) {
+        value = 0; // Subnormal, below float range anyway
+    } else if (exponent == 0x7FF) {
+        value = mantissa == 0 ? INFINITY : NAN;
+    } else {
+        value = ldexp((double)(mantissa | 0x10000000000000ULL), exponent - 1075);
+    }
+    return (bits >> 63) ? -value : value;
+}
+
+bool CborToken::isInteger() {
+    return type == CBOR_UNSIGNED || type == CBOR_NEGATIVE;
+}
+
+bool CborToken::isBool() {
+    return type == CBOR_SIMPLE && (value == 20 || value == 21);
+}
+
+bool CborToken::isNull() {
+    return type == CBOR_SIMPLE && value == 22;
+}
+
+double CborToken::asNumber() {
+    switch (type) {
+        case CBOR_UNSIGNED: return (double)value;
+        case CBOR_NEGATIVE: return -1.0 - (double)value;
+        case CBOR_FLOAT: return number;
+        case CBOR_SIMPLE: return value == 21 ? 1 : 0;
+        default: return 0;
+    }
+}
+
+int64_t CborToken::asLong() {
+    switch (type) {
+        case CBOR_UNSIGNED: return value > (uint64_t)longMax ? longMax : (int64_t)value;
+        case CBOR_NEGATIVE: return value > (uint64_t)longMax ? longMin : -1 - (int64_t)value;
+        case CBOR_FLOAT: return (int64_t)number;
+        case CBOR_SIMPLE: return value == 21 ? 1 : 0;
+        default: return 0;
+    }
+}
+
+int32_t CborToken::asInt() {
+    int64_t value = asLong();
+    if (value > intMax) return intMax;
+    if (value < intMin) return intMin;
+    return (int32_t)value;
+}
+
+bool CborToken::asBool() {
+    if (type == CBOR_SIMPLE) return value == 21;
+    return asNumber() != 0;
+}
+
+bool CborToken::equals(const char *text) {
+    if (type != CBOR_STRING && type != CBOR_BYTES) return false;
+    return strlen(text) == length && memcmp(data, text, length) == 0;
+}
+
+unsigned int CborToken::copyTo(char *out, unsigned int size) {
+    if (size == 0) return 0;
+    unsigned int count = 0;
+    if (type == CBOR_STRING || type == CBOR_BYTES) {
+        count = length < size - 1 ? length : size - 1;
+        memcpy(out, data, count);
+    }
+    out[count] = 0;
+    return count;
+}
+
+CborCursor::CborCursor(const unsigned char *data, unsigned int size) {
+    this->data = data;
+    this->size = size;
+}
+
+bool CborCursor::isValid() {
+    return valid;
+}
+
+bool CborCursor::atEnd() {
+    return offset >= size;
+}
+
+unsigned int CborCursor::getOffset() {
+    return offset;
+}
+
+bool CborCursor::fail() {
+    valid = false;
+    return false;
+}
+
+bool CborCursor::read(unsigned int count, uint64_t &value) {
+    if (size - offset < count) return fail();
+
+    value = 0;
+    for (unsigned int i = 0; i < count; ++i) {
+        value = (value << 8) | data[offset++];
+    }
+    return true;
+}
+
+bool CborCursor::next(CborToken &token) {
+    if (!valid || offset >= size) return false;
+
+    unsigned char initial = data[offset++];
+    unsigned char major = initial >> 5;
+    unsigned char minor = initial & 31;
+
+    token.value = 0;
+    token.data = 0;
+    token.length = 0;
+    token.number = 0;
+    token.indefinite = false;
+
+    if (major == 7) {
+        if (minor < 24) {
+            token.type = CBOR_SIMPLE;
+            token.value = minor;
+        } else if (minor == 24) {
+            token.type = CBOR_SIMPLE;
+            if (!read(1, token.value)) return false;
+        } else if (minor == 25) {
+            token.type = CBOR_FLOAT;
+            if (!read(2, token.value)) return false;
+            token.number = halfToDouble(token.value);
+        } else if (minor == 26) {
+            token.type = CBOR_FLOAT;
+            if (!read(4, token.value)) return false;
+            float single;
+            uint32_t bits = token.value;
+            memcpy(&single, &bits, sizeof(single));
+            token.number = single;
+        } else if (minor == 27) {
+            token.type = CBOR_FLOAT;
+            if (!read(8, token.value)) return false;
+            token.number = doubleFromBits(token.value);
+        } else if (minor == 31) {
+            token.type = CBOR_BREAK;
+        } else {
+            return fail();
+        }
+        return true;
+    }
+
+    token.type = (CborTokenType)major;
+    if (minor < 24) {
+        token.value = minor;
+    } else if (minor <= 27) {
+        if (!read(1 << (minor - 24), token.value)) return false;
+    } else if (minor == 31 && (major == 4 || major == 5)) {
+        token.indefinite = true;
+    } else {
+        // Reserved, or indefinite where it is not supported (strings are
+        // only handled as single chunks).
+        return fail();
+    }
+
+    if (major == 2 || major == 3) {
+        if (token.value > size - offset) return fail();
+        token.data = data + offset;
+        token.length = token.value;
+        offset += token.length;
+    } else if (!token.indefinite && (major == 4 || major == 5)) {
+        // Every item takes at least a byte; rejects absurd lengths early.
+        uint64_t items = major == 5 ? token.value * 2 : token.value;
+        if (token.value > size - offset || items > size - offset) return fail();
+    }
+    return true;
+}
+
+bool CborCursor::skip() {
+    CborToken token;
+    if (!next(token)) return fail();
+    if (token.type == CBOR_BREAK) return fail();
+    return skip(token, 0);
+}
+
+bool CborCursor::skip(const CborToken &token) {
+    return skip(token, 0);
+}
+
+bool CborCursor::skip(const CborToken &token, unsigned int depth) {
+    if (token.type != CBOR_ARRAY && token.type != CBOR_MAP && token.type != CBOR_TAG) {
+        return valid;
+    }
+    if (depth >= maxDepth) return fail();
+
+    CborToken item;
+    if (token.type == CBOR_TAG) {
+        if (!next(item) || item.type == CBOR_BREAK) return fail();
+        return skip(item, depth + 1);
+    }
+
+    uint64_t items = token.type == CBOR_MAP ? token.value * 2 : token.value;
+    for (uint64_t i = 0; token.indefinite || i < items; ++i) {
+        if (!next(item)) return fail();
+        if (item.type == CBOR_BREAK) {
+            // Maps need an even number of items.
+            if (!token.indefinite || (token.type == CBOR_MAP && i % 2 != 0)) return fail();
+            return true;
+        }
+        if (!skip(item, depth + 1)) return false;
+    }
+    return true;
+}
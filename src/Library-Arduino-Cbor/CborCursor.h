@@ -0,0 +1,93 @@
+#ifndef CBORCURSOR_H
+#define CBORCURSOR_H
+
+#include <stdint.h>
+
+// Pull parser over a CBOR buffer. Every call to next() yields one token;
+// strings and byte strings point into the buffer instead of being copied,
+// nothing is allocated and every read is bounds-checked. The buffer must
+// outlive the tokens.
+//
+//   CborCursor cursor(bytes, size);
+//   CborToken token;
+//   while (cursor.next(token)) {
+//       if (token.type == CBOR_STRING && token.equals("led")) ...
+//   }
+//   if (!cursor.isValid()) ... // malformed or truncated
+//
+// Arrays and maps only yield their header (value holds the number of items,
+// or pairs for a map); their items follow as separate tokens. skip() passes
+// over a whole item including everything nested in it.
+//
+// This header has no Arduino dependencies, so backend tools can use it too.
+
+enum CborTokenType {
+    CBOR_UNSIGNED,   // value
+    CBOR_NEGATIVE,   // -1 - value
+    CBOR_BYTES,      // data, length
+    CBOR_STRING,     // data, length; UTF-8, not terminated
+    CBOR_ARRAY,      // value items, or indefinite until CBOR_BREAK
+    CBOR_MAP,        // value pairs, or indefinite until CBOR_BREAK
+    CBOR_TAG,        // value; the tagged item is the next token
+    CBOR_SIMPLE,     // value: 20 false, 21 true, 22 null, 23 undefined
+    CBOR_FLOAT,      // number; half, single and double precision
+    CBOR_BREAK       // end of an indefinite array or map
+};
+
+struct CborToken {
+    CborTokenType type;
+    uint64_t value;
+    const unsigned char *data;
+    unsigned int length;
+    double number;
+    bool indefinite;
+
+    bool isInteger();
+    bool isBool();
+    bool isNull();
+
+    // Integers and floats as a number, booleans as 0 or 1.
+    double asNumber();
+    // Integers clamped to the int32 range, floats truncated.
+    int32_t asInt();
+    int64_t asLong();
+    bool asBool();
+
+    // Compares a string or byte string token with a zero-terminated string.
+    bool equals(const char *text);
+
+    // Copies a string token into out, truncated and always terminated.
+    // Returns the number of characters copied.
+    unsigned int copyTo(char *out, unsigned int size);
+};
+
+class CborCursor {
+public:
+    static const unsigned int maxDepth = 16; // Nesting skip() descends into
+
+    CborCursor(const unsigned char *data, unsigned int size);
+
+    // Returns false at the end of the buffer or on malformed input.
+    bool next(CborToken &token);
+
+    // Passes over the next item, or over the contents of token if it is an
+    // array, map or tag that was just read.
+    bool skip();
+    bool skip(const CborToken &token);
+
+    bool isValid();
+    bool atEnd();
+    unsigned int getOffset();
+
+private:
+    const unsigned char *data;
+    unsigned int size;
+    unsigned int offset = 0;
+    bool valid = true;
+
+    bool fail();
+    bool read(unsigned int count, uint64_t &value);
+    bool skip(const CborToken &token, unsigned int depth);
+};
+
+#endif
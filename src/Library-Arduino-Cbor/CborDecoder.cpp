@@ -13,32 +13,38 @@ CborInput::~CborInput() {}
 
 
 bool CborInput::hasBytes(unsigned int count) {
-	return size - offset >= count;
+	return offset <= size && (unsigned int)(size - offset) >= count;
 }
 
+// Reads past the end return 0 and leave the offset where it is.
 unsigned char CborInput::getByte() {
+	if (!hasBytes(1)) return 0;
 	return data[offset++];
 }
 
 unsigned short CborInput::getShort() {
+	if (!hasBytes(2)) return 0;
 	unsigned short value = ((unsigned short)data[offset] << 8) | ((unsigned short)data[offset + 1]);
 	offset += 2;
 	return value;
 }
 
 uint32_t CborInput::getInt() {
+	if (!hasBytes(4)) return 0;
 	uint32_t value = ((uint32_t)data[offset] << 24) | ((uint32_t)data[offset + 1] << 16) | ((uint32_t)data[offset + 2] << 8) | ((uint32_t)data[offset + 3]);
 	offset += 4;
 	return value;
 }
 
 uint64_t CborInput::getLong() {
+	if (!hasBytes(8)) return 0;
 	uint64_t value = ((uint64_t)data[offset] << 56) | ((uint64_t)data[offset+1] << 48) | ((uint64_t)data[offset+2] << 40) | ((uint64_t)data[offset+3] << 32) | ((uint64_t)data[offset+4] << 24) | ((uint64_t)data[offset+5] << 16) | ((uint64_t)data[offset+6] << 8) | ((uint64_t)data[offset+7]);
 	offset += 8;
 	return value;
 }
 
 void CborInput::getBytes(void *to, int count) {
+	if (count < 0 || !hasBytes(count)) return;
 	memcpy(to, data + offset, count);
 	offset += count;
 }
@@ -341,10 +347,11 @@ void CborReader::Run() {
 			} else break;
 		} else if(state == STATE_STRING_DATA) {
 			if(input->hasBytes(currentLength)) {
-				unsigned char data[currentLength];
+				unsigned char data[currentLength + 1];
 				//Serial.print("currentLength:");
 				//Serial.println(currentLength);
 				input->getBytes(data, currentLength);
+				data[currentLength] = 0;
 				state = STATE_TYPE;
 				String str = (const char *) data;
 				listener->OnString(str);
@@ -770,10 +777,11 @@ void CborReader::GetCborData(String &Cborpackage) {
 			} else break;
 		} else if(state == STATE_STRING_DATA) {
 			if(input->hasBytes(currentLength)) {
-				unsigned char data[currentLength];
+				unsigned char data[currentLength + 1];
 				//Serial.print("currentLength:");
 				//Serial.println(currentLength);
 				input->getBytes(data, currentLength);
+				data[currentLength] = 0;
 				state = STATE_TYPE;
 				String str = (const char *) data;
 				Cborpackage +=  (const char *) data;
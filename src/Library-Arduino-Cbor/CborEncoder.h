@@ -21,6 +21,7 @@
 #define CBOREN_H
 
 #include "Arduino.h"
+#include "CborWriterT.h"
 
 class CborOutput {
 public:
@@ -39,11 +40,14 @@ public:
 	virtual unsigned int getSize();
 	virtual void putByte(unsigned char value);
 	virtual void putBytes(const unsigned char *data, const unsigned int size);
+	bool hasOverflowed();
+	void rewind(unsigned int size); // Drops everything after size and clears the overflow
 private:
 	unsigned char *buffer;
 	unsigned int capacity;
 	unsigned int offset;
     bool releaseBuffer;
+	bool overflow;
 };
 
 
@@ -65,18 +69,36 @@ private:
     unsigned int offset;
 };
 
+// Adapts any CborOutput to CborWriterT.
+class CborOutputSink {
+public:
+	CborOutputSink(CborOutput &output) : output(&output) { }
+
+	void put(const unsigned char *head, unsigned int headSize, const unsigned char *body, unsigned int bodySize) {
+		output->putBytes(head, headSize);
+		if (bodySize > 0) {
+			output->putBytes(body, bodySize);
+		}
+	}
+
+private:
+	CborOutput *output;
+};
+
+// Writes through the virtual CborOutput interface. Kept for existing code;
+// CborWriterT<CborBufferSink> does the same without the virtual calls.
 class CborWriter {
 public:
 	CborWriter(CborOutput &output);
 	~CborWriter();
 
-	void writeInt(const int value);
-	void writeInt(const int32_t value);
-	void writeInt(const int64_t value);
-	void writeInt(const uint32_t value);
-	void writeInt(const uint64_t value);
+	// Any integer type; negative values use major type 1.
+	template<typename T> void writeInt(const T value) {
+		writer.writeInt(value);
+	}
 	void writeBytes(const unsigned char *data, const unsigned int size);
 	void writeString(const char *data, const unsigned int size);
+	void writeString(const char *data);
 	void writeString(const String str);
 	void writeArray(const unsigned int size);
 	void writeMap(const unsigned int size);
@@ -85,9 +107,8 @@ public:
     void writeFloat(float value);
     void writeDouble(double value);
 private:
-	void writeTypeAndValue(uint8_t majorType, const uint32_t value);
-	void writeTypeAndValue(uint8_t majorType, const uint64_t value);
-	CborOutput *output;
+	CborOutputSink sink;
+	CborWriterT<CborOutputSink> writer;
 };
 
 class CborSerializable {
@@ -0,0 +1,154 @@
+#ifndef CBORWRITERT_H
+#define CBORWRITERT_H
+
+#include <string.h>
+#include <stdint.h>
+
+#include "../ByteOrder.h"
+
+// CBOR writer that is templated on its output, so that the output calls are
+// inlined. Every item (header plus any string or byte payload) is handed to
+// the sink in one put(), which checks the capacity once and writes either
+// all of it or nothing.
+//
+// A sink provides:
+//
+//   void put(const unsigned char *head, unsigned int headSize,
+//            const unsigned char *body, unsigned int bodySize);
+
+// Writes into a fixed buffer and remembers if anything did not fit.
+class CborBufferSink {
+public:
+    CborBufferSink(unsigned char *buffer, unsigned int capacity)
+        : buffer(buffer), capacity(capacity), offset(0), overflow(false) { }
+
+    void put(const unsigned char *head, unsigned int headSize, const unsigned char *body, unsigned int bodySize) {
+        if (headSize + bodySize > capacity - offset) {
+            overflow = true;
+            return;
+        }
+        memcpy(buffer + offset, head, headSize);
+        offset += headSize;
+        if (bodySize > 0) {
+            memcpy(buffer + offset, body, bodySize);
+            offset += bodySize;
+        }
+    }
+
+    unsigned char *getData() { return buffer; }
+    unsigned int getSize() { return offset; }
+    bool hasOverflowed() { return overflow; }
+
+    // Drops everything after size and clears the overflow.
+    void rewind(unsigned int size) {
+        if (size < offset) offset = size;
+        overflow = false;
+    }
+
+private:
+    unsigned char *buffer;
+    unsigned int capacity;
+    unsigned int offset;
+    bool overflow;
+};
+
+template<typename Sink> class CborWriterT {
+public:
+    static const unsigned int maxHeadSize = 9;
+
+    CborWriterT(Sink &sink) : sink(&sink) { }
+
+    // Signed and unsigned integers of any width; negative values use major
+    // type 1.
+    template<typename T> void writeInt(T value) {
+        typedef typename UnsignedOfSize<(sizeof(T) > 4 ? 8 : 4)>::Type Unsigned;
+        if (value < 0) {
+            writeTypeAndValue(1, (Unsigned)(-(value + 1)));
+        } else {
+            writeTypeAndValue(0, (Unsigned)value);
+        }
+    }
+
+    void writeBytes(const unsigned char *data, unsigned int size) {
+        writeItem(2, size, data);
+    }
+
+    void writeString(const char *data, unsigned int size) {
+        writeItem(3, size, (const unsigned char *)data);
+    }
+
+    void writeString(const char *data) {
+        writeString(data, strlen(data));
+    }
+
+    void writeArray(unsigned int size) { writeTypeAndValue(4, (uint32_t)size); }
+    void writeMap(unsigned int size) { writeTypeAndValue(5, (uint32_t)size); }
+    void writeTag(uint32_t tag) { writeTypeAndValue(6, tag); }
+    void writeSpecial(uint32_t special) { writeTypeAndValue(7, special); }
+
+    void writeFloat(float value) {
+        writeNumber(value);
+    }
+
+    // Single precision where double is 4 bytes (AVR).
+    void writeDouble(double value) {
+        writeNumber(value);
+    }
+
+    void writeTypeAndValue(uint8_t majorType, uint32_t value) {
+        unsigned char head[maxHeadSize];
+        sink->put(head, encodeHead(head, majorType, value), 0, 0);
+    }
+
+    void writeTypeAndValue(uint8_t majorType, uint64_t value) {
+        unsigned char head[maxHeadSize];
+        sink->put(head, encodeHead(head, majorType, value), 0, 0);
+    }
+
+    static unsigned int encodeHead(unsigned char *out, uint8_t majorType, uint32_t value) {
+        majorType <<= 5;
+        if (value < 24) {
+            out[0] = majorType | value;
+            return 1;
+        } else if (value < 256) {
+            out[0] = majorType | 24;
+            out[1] = value;
+            return 2;
+        } else if (value < 65536) {
+            out[0] = majorType | 25;
+            storeBigEndian(out + 1, (uint16_t)value);
+            return 3;
+        }
+        out[0] = majorType | 26;
+        storeBigEndian(out + 1, value);
+        return 5;
+    }
+
+    static unsigned int encodeHead(unsigned char *out, uint8_t majorType, uint64_t value) {
+        if (value <= 0xFFFFFFFFULL) {
+            return encodeHead(out, majorType, (uint32_t)value);
+        }
+        out[0] = (majorType << 5) | 27;
+        storeBigEndian(out + 1, value);
+        return 9;
+    }
+
+private:
+    Sink *sink;
+
+    void writeItem(uint8_t majorType, unsigned int size, const unsigned char *body) {
+        unsigned char head[maxHeadSize];
+        sink->put(head, encodeHead(head, majorType, (uint32_t)size), body, size);
+    }
+
+    template<typename T> void writeNumber(T value) {
+        unsigned char head[1 + sizeof(T)];
+        head[0] = sizeof(T) == 8 ? 0xFB : 0xFA;
+        storeBigEndian(head + 1, value);
+        sink->put(head, sizeof(head), 0, 0);
+    }
+};
+
+template<typename Sink> const unsigned int CborWriterT<Sink>::maxHeadSize;
+
+#endif
@@ -114,6 +114,9 @@ bool LoRaModem::connect(ABPCredentials &abpCredentials) {
     if (!setMacParam("nwkskey", abpCredentials.getNetworkSessionKey(), 16))
         return false;
 
+    if (counterStore && !restoreFrameCounters())
+        return false;
+
     loraSerial->print("mac join abp\r\n");
     return expectOk() && expectAccepted(30000);
 }
@@ -133,6 +136,47 @@ bool LoRaModem::connect(OTAACredentials &otaaCredentials) {
     return expectOk() && expectAccepted(30000);
 }
 
+void LoRaModem::setFrameCounterStore(FrameCounterStore &store) {
+    counterStore = &store;
+}
+
+bool LoRaModem::restoreFrameCounters() {
+    uint32_t up, down;
+    if (!counterStore->begin()) {
+        log("Frame counter storage not readable.");
+        return false;
+    }
+
+    // Without a checkpoint, the counters the modem has now are the start.
+    if (!counterStore->hasCheckpoint()) {
+        return getFrameCounters(up, down) && counterStore->save(up, down);
+    }
+    if (!counterStore->restore(up, down)) {
+        log("Frame counter checkpoint not writable.");
+        return false;
+    }
+    return setMacParam("upctr", up) && setMacParam("dnctr", down);
+}
+
+bool LoRaModem::getFrameCounters(uint32_t &up, uint32_t &down) {
+    char *end;
+    char *value = getMacParam("upctr");
+    up = strtoul(value, &end, 10);
+    if (end == value)
+        return false;
+
+    value = getMacParam("dnctr");
+    down = strtoul(value, &end, 10);
+    return end != value;
+}
+
+void LoRaModem::checkpointFrameCounters() {
+    uint32_t up, down;
+    if (!getFrameCounters(up, down) || !counterStore->update(up, down)) {
+        log("Frame counter checkpoint failed.");
+    }
+}
+
 bool LoRaModem::reset(unsigned int retries) {
     log("Resetting the modem.");
     loraSerial->print("sys reset\r\n");
@@ -197,6 +241,25 @@ unsigned int LoRaModem::getMaxPayloadSize() {
     return maxPayloadSize;
 }
 
+// Application payload limits (excluding FOpts) per data rate, per the EU868
+// and US915 regional parameters. DR0 has the lowest.
+static const unsigned char euPayloadSizes[] = { 51, 51, 51, 115, 222, 222, 222, 222 };
+static const unsigned char usPayloadSizes[] = { 11, 53, 125, 242, 242 };
+
+// Falls back to the DR0 limit when the modem does not answer.
+unsigned int LoRaModem::getDataRateMaxPayloadSize() {
+    char *dataRate = getDataRate();
+    int dr = dataRate != NULL ? atoi(dataRate) : 0;
+
+    unsigned int size;
+    if (isRN2903) {
+        size = usPayloadSizes[dr >= 0 && dr < (int)sizeof(usPayloadSizes) ? dr : 0];
+    } else {
+        size = euPayloadSizes[dr >= 0 && dr < (int)sizeof(euPayloadSizes) ? dr : 0];
+    }
+    return size < maxPayloadSize ? size : maxPayloadSize;
+}
+
 unsigned int LoRaModem::setPort(unsigned int port) {
     if (port <= 0 || port > 223) {
         log("Port not in expected range (1-223). Port 1 will be used instead.");
@@ -240,9 +303,45 @@ bool LoRaModem::setAdaptiveDataRate(bool adr) {
 }
 
 bool LoRaModem::send(Payload &payload) {
+    Payload *segments[] = { &payload };
+    return transmit(segments, 1, options.port, options.ack);
+}
+
+bool LoRaModem::send(Payload *const *segments, unsigned int count) {
+    return transmit(segments, count, options.port, options.ack);
+}
+
+bool LoRaModem::send(Payload &payload, LoRaOptions &options) {
+    Payload *segments[] = { &payload };
+    return transmit(segments, 1, options.port, options.ack);
+}
+
+bool LoRaModem::send(Payload &payload, unsigned int port, bool ack) {
+    Payload *segments[] = { &payload };
+    return transmit(segments, 1, port, ack);
+}
+
+bool LoRaModem::send(Payload *const *segments, unsigned int count, LoRaOptions &options) {
+    return transmit(segments, count, options.port, options.ack);
+}
+
+bool LoRaModem::transmit(Payload *const *segments, unsigned int count, unsigned int port, bool ack) {
     char buffer[3]; // hex conversion buffer
 
-    if (payload.getSize() > getMaxPayloadSize()) {
+    if (port == 0 || port > 223) {
+        log("Port not in expected range (1-223), not sending.");
+        return false;
+    }
+
+    unsigned int size = 0;
+    for (unsigned int i = 0; i < count; ++i) {
+        size += segments[i]->getSize();
+    }
+
+    // Anything up to the DR0 limit fits at every data rate, so only larger
+    // frames cost a query for the current one.
+    unsigned int alwaysFits = isRN2903 ? usPayloadSizes[0] : euPayloadSizes[0];
+    if (size > getMaxPayloadSize() || (size > alwaysFits && size > getDataRateMaxPayloadSize())) {
         log("Can't send the payload, size too big.");
         return false;
     }
@@ -250,15 +349,19 @@ bool LoRaModem::send(Payload &payload) {
     // Start sending payload.
     log("Sending:", ' ');
     loraSerial->print("mac tx ");
-    loraSerial->print(options.ack ? "cnf " : "uncnf ");
-    loraSerial->print(options.port);
+    loraSerial->print(ack ? "cnf " : "uncnf ");
+    loraSerial->print(port);
     loraSerial->print(" ");
 
-    unsigned char *bytes = payload.getBytes();
-    for (auto i = 0; i < payload.getSize(); ++i) {
-        sprintf(buffer, "%.2X", bytes[i]);
-        log(buffer, ' ');
-        loraSerial->print(buffer);
+    // Each segment is hex-encoded straight from its own buffer.
+    for (unsigned int i = 0; i < count; ++i) {
+        unsigned char *bytes = segments[i]->getBytes();
+        unsigned int length = segments[i]->getSize();
+        for (unsigned int j = 0; j < length; ++j) {
+            sprintf(buffer, "%.2X", bytes[j]);
+            log(buffer, ' ');
+            loraSerial->print(buffer);
+        }
     }
     log("");
     loraSerial->print("\r\n");
@@ -269,7 +372,12 @@ bool LoRaModem::send(Payload &payload) {
         return false;
     }
 
-    return receive();
+    // The uplink counter is used up from here, whatever the outcome.
+    bool received = receive();
+    if (counterStore && credentialsType == abp) {
+        checkpointFrameCounters();
+    }
+    return received;
 }
 
 bool LoRaModem::receive() {
@@ -283,9 +391,8 @@ bool LoRaModem::receive() {
     } else if (strstr(response, "mac_rx") != nullptr) {
         log("Received mac_rx (downlink found)");
         if (callback != nullptr) {
-            auto downlink = parseMacRx(response);
-            callback(downlink->payload, downlink->options);
-            free(downlink);
+            LoRaDownlink downlink = parseMacRx(response);
+            callback(downlink.payload, downlink.options);
         } else {
             log("No downlink callback set.");
         }
@@ -297,30 +404,25 @@ bool LoRaModem::receive() {
     }
 }
 
-LoRaDownlink *LoRaModem::parseMacRx(char *macRx) {
-    auto downlink = new LoRaDownlink();
-
-    char convBuffer[3]; // hex conversion buffer
-
+LoRaDownlink LoRaModem::parseMacRx(char *macRx) {
     // discard "mac_rx"
     strtok(macRx, " ");
 
-    // get port
     char *port = strtok(nullptr, " ");
-    downlink->options.port = strtol(port, nullptr, 10);
-
-    // get payload
     char *payload = strtok(nullptr, " ");
-    unsigned int payloadLength = strlen(payload);
-    auto buffer = new unsigned char[(strlen(payload) / 2)];
 
-    for (auto i = 0; i < payloadLength; i += 2) {
-        strncpy(convBuffer, payload + i, 2);
-        buffer[i/2] = strtol(convBuffer, nullptr, 16);
+    // Decoded in place: byte i only overwrites hex digits that were already
+    // read, so the payload needs no buffer of its own.
+    unsigned char *bytes = reinterpret_cast<unsigned char *>(payload);
+    unsigned int size = payload != nullptr ? strlen(payload) / 2 : 0;
+    for (unsigned int i = 0; i < size; ++i) {
+        bytes[i] = HEX_PAIR_TO_BYTE(payload[2 * i], payload[2 * i + 1]);
     }
 
-    BinaryPayload binaryPayload(buffer, (strlen(payload) / 2));
-    downlink->payload = binaryPayload;
+    LoRaDownlink downlink = {
+        BinaryPayload(bytes, size),
+        LoRaOptions(port != nullptr ? strtol(port, nullptr, 10) : 0)
+    };
     return downlink;
 }
 
@@ -9,11 +9,15 @@
 #include "OTAACredentials.h"
 #include "Options.h"
 #include "LoRaOptions.h"
+#include "FrameCounterStore.h"
 
 #include <stdint.h>
 
 enum LoRaCredentialsType { unknown, abp, otaa };
 
+// The payload points into the modem's input buffer: it is only valid
+// during the downlink callback, and only until the callback talks to the
+// modem again.
 struct LoRaDownlink {
     BinaryPayload payload;
     LoRaOptions options;
@@ -29,6 +33,10 @@ public:
     bool init(OTAACredentials &otaaCredentials);
     bool init();
 
+    // ABP only: init() continues the frame counters from the store, and
+    // every uplink checkpoints them there.
+    void setFrameCounterStore(FrameCounterStore &store);
+
     unsigned int setPort(unsigned int port);
     void setAck(bool ack);
 
@@ -55,11 +63,18 @@ public:
 
     unsigned int getDefaultBaudRate();
     unsigned int getMaxPayloadSize();
+    unsigned int getDataRateMaxPayloadSize();
 
     char *getLastErrorCode();
     char *humanizeErrorCode(char *errorCode);
 
     bool send(Payload &payload);
+    bool send(Payload *const *segments, unsigned int count);
+
+    // Port and ack for this uplink only; they go straight into the command.
+    bool send(Payload &payload, LoRaOptions &options);
+    bool send(Payload &payload, unsigned int port, bool ack = false);
+    bool send(Payload *const *segments, unsigned int count, LoRaOptions &options);
 
     using Device<LoRaOptions>::send;
     using Device<LoRaOptions>::setDownlinkCallback;
@@ -80,8 +95,13 @@ private:
     bool expectOk(unsigned int timeout = 1000);
     bool expectAccepted(unsigned int timeout = 1000);
 
+    bool restoreFrameCounters();
+    bool getFrameCounters(uint32_t &up, uint32_t &down);
+    void checkpointFrameCounters();
+
+    bool transmit(Payload *const *segments, unsigned int count, unsigned int port, bool ack);
     bool receive();
-    LoRaDownlink *parseMacRx(char *macRx);
+    LoRaDownlink parseMacRx(char *macRx);
 
     char *getParam(const char *type, const char *name, unsigned short timeout = defaultTimeout);
 
@@ -104,6 +124,8 @@ private:
     HardwareSerial *loraSerial;
     Stream *debugStream;
 
+    FrameCounterStore *counterStore = nullptr;
+
     LoRaCredentialsType credentialsType;
     ABPCredentials abpCredentials;
     OTAACredentials otaaCredentials;
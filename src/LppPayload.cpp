@@ -0,0 +1,190 @@
+#include "LppPayload.h"
+
+LppPayload::LppPayload(unsigned int capacity) {
+    this->capacity = capacity;
+    this->buffer = new unsigned char[capacity];
+}
+
+LppPayload::~LppPayload() {
+    delete[] buffer;
+}
+
+unsigned char *LppPayload::getBytes() {
+    return buffer;
+}
+
+unsigned int LppPayload::getSize() {
+    return offset;
+}
+
+void LppPayload::reset() {
+    offset = 0;
+}
+
+bool LppPayload::getLayout(uint8_t type, unsigned int &values, unsigned int &size, float &resolution, bool &isSigned) {
+    values = 1;
+    isSigned = false;
+    switch (type) {
+        case digitalInput:
+        case digitalOutput:
+        case presence:
+            size = 1; resolution = 1;
+            return true;
+        case analogInput:
+        case analogOutput:
+            size = 2; resolution = 0.01f; isSigned = true;
+            return true;
+        case luminosity:
+            size = 2; resolution = 1;
+            return true;
+        case temperature:
+            size = 2; resolution = 0.1f; isSigned = true;
+            return true;
+        case relativeHumidity:
+            size = 1; resolution = 0.5f;
+            return true;
+        case accelerometer:
+            values = 3; size = 2; resolution = 0.001f; isSigned = true;
+            return true;
+        case barometricPressure:
+            size = 2; resolution = 0.1f;
+            return true;
+        case gyrometer:
+            values = 3; size = 2; resolution = 0.01f; isSigned = true;
+            return true;
+        case gps:
+            // Altitude has its own resolution, see add() and next().
+            values = 3; size = 3; resolution = 0.0001f; isSigned = true;
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool LppPayload::add(uint8_t channel, uint8_t type, const float *values) {
+    unsigned int count, size;
+    float resolution;
+    bool isSigned;
+    getLayout(type, count, size, resolution, isSigned);
+
+    if (2 + count * size + offset > capacity)
+        return false;
+
+    // Everything is checked before anything is written. The comparison
+    // also fails for NaN.
+    int32_t raw[3];
+    int32_t max = isSigned ? ((int32_t)1 << (8 * size - 1)) - 1 : ((int32_t)1 << (8 * size)) - 1;
+    int32_t min = isSigned ? -max - 1 : 0;
+    for (unsigned int i = 0; i < count; ++i) {
+        float scaled = values[i] / (type == gps && i == 2 ? 0.01f : resolution);
+        if (!(scaled > min - 0.5f && scaled < max + 0.5f))
+            return false;
+        raw[i] = (int32_t)(scaled + (scaled < 0 ? -0.5f : 0.5f));
+    }
+
+    buffer[offset++] = channel;
+    buffer[offset++] = type;
+    for (unsigned int i = 0; i < count; ++i) {
+        for (int byte = size - 1; byte >= 0; --byte) {
+            buffer[offset++] = raw[i] >> (8 * byte);
+        }
+    }
+    return true;
+}
+
+bool LppPayload::addDigitalInput(uint8_t channel, uint8_t value) {
+    float values[] = { (float)value };
+    return add(channel, digitalInput, values);
+}
+
+bool LppPayload::addDigitalOutput(uint8_t channel, uint8_t value) {
+    float values[] = { (float)value };
+    return add(channel, digitalOutput, values);
+}
+
+bool LppPayload::addAnalogInput(uint8_t channel, float value) {
+    return add(channel, analogInput, &value);
+}
+
+bool LppPayload::addAnalogOutput(uint8_t channel, float value) {
+    return add(channel, analogOutput, &value);
+}
+
+bool LppPayload::addLuminosity(uint8_t channel, uint16_t lux) {
+    float values[] = { (float)lux };
+    return add(channel, luminosity, values);
+}
+
+bool LppPayload::addPresence(uint8_t channel, uint8_t value) {
+    float values[] = { (float)value };
+    return add(channel, presence, values);
+}
+
+bool LppPayload::addTemperature(uint8_t channel, float celsius) {
+    return add(channel, temperature, &celsius);
+}
+
+bool LppPayload::addRelativeHumidity(uint8_t channel, float percent) {
+    return add(channel, relativeHumidity, &percent);
+}
+
+bool LppPayload::addAccelerometer(uint8_t channel, float x, float y, float z) {
+    float values[] = { x, y, z };
+    return add(channel, accelerometer, values);
+}
+
+bool LppPayload::addBarometricPressure(uint8_t channel, float hectopascal) {
+    return add(channel, barometricPressure, &hectopascal);
+}
+
+bool LppPayload::addGyrometer(uint8_t channel, float x, float y, float z) {
+    float values[] = { x, y, z };
+    return add(channel, gyrometer, values);
+}
+
+bool LppPayload::addGPS(uint8_t channel, float latitude, float longitude, float altitude) {
+    float values[] = { latitude, longitude, altitude };
+    return add(channel, gps, values);
+}
+
+bool LppPayload::addGPS(uint8_t channel, GeoLocation location) {
+    return addGPS(channel, location.latitude, location.longitude, location.altitude);
+}
+
+LppReader::LppReader(const unsigned char *bytes, unsigned int size) {
+    this->bytes = bytes;
+    this->size = size;
+}
+
+bool LppReader::isValid() {
+    return valid;
+}
+
+bool LppReader::next(uint8_t &channel, uint8_t &type, float *values, unsigned int &count) {
+    if (!valid || offset >= size)
+        return false;
+
+    unsigned int valueSize;
+    float resolution;
+    bool isSigned;
+    if (size - offset < 2 || !LppPayload::getLayout(bytes[offset + 1], count, valueSize, resolution, isSigned)
+            || size - offset - 2 < count * valueSize) {
+        valid = false;
+        return false;
+    }
+
+    channel = bytes[offset++];
+    type = bytes[offset++];
+    for (unsigned int i = 0; i < count; ++i) {
+        uint32_t raw = 0;
+        for (unsigned int byte = 0; byte < valueSize; ++byte) {
+            raw = (raw << 8) | bytes[offset++];
+        }
+        int32_t value = raw;
+        if (isSigned && (raw & (1UL << (8 * valueSize - 1)))) {
+            value = (int32_t)(raw - (1UL << (8 * valueSize - 1)) * 2);
+        }
+        values[i] = value * (type == LppPayload::gps && i == 2 ? 0.01f : resolution);
+    }
+    return true;
+}
@@ -0,0 +1,81 @@
+#ifndef LPP_PAYLOAD_H_
+#define LPP_PAYLOAD_H_
+
+#include "Payload.h"
+#include "GeoLocation.h"
+
+#include <stdint.h>
+
+// Cayenne Low Power Payload: each value is a channel byte, a type byte and a
+// fixed-point value of fixed size, big-endian.
+class LppPayload : public Payload {
+public:
+    enum Type {
+        digitalInput = 0,       // 1 byte
+        digitalOutput = 1,      // 1 byte
+        analogInput = 2,        // 2 bytes, signed, 0.01
+        analogOutput = 3,       // 2 bytes, signed, 0.01
+        luminosity = 101,       // 2 bytes, unsigned, 1 lux
+        presence = 102,         // 1 byte
+        temperature = 103,      // 2 bytes, signed, 0.1 °C
+        relativeHumidity = 104, // 1 byte, unsigned, 0.5 %
+        accelerometer = 113,    // 3 x 2 bytes, signed, 0.001 G
+        barometricPressure = 115, // 2 bytes, unsigned, 0.1 hPa
+        gyrometer = 134,        // 3 x 2 bytes, signed, 0.01 °/s
+        gps = 136               // 3 x 3 bytes, signed, 0.0001 °, 0.0001 °, 0.01 m
+    };
+
+    LppPayload(unsigned int capacity = 51); // Lowest LoRa payload length.
+    ~LppPayload();
+    LppPayload(const LppPayload &) = delete;
+    LppPayload &operator=(const LppPayload &) = delete;
+
+    // Return false, leaving the payload as it was, if the value does not
+    // fit, or is out of the range of its type (e.g. above 3276.7 °C), or NaN.
+    bool addDigitalInput(uint8_t channel, uint8_t value);
+    bool addDigitalOutput(uint8_t channel, uint8_t value);
+    bool addAnalogInput(uint8_t channel, float value);
+    bool addAnalogOutput(uint8_t channel, float value);
+    bool addLuminosity(uint8_t channel, uint16_t lux);
+    bool addPresence(uint8_t channel, uint8_t value);
+    bool addTemperature(uint8_t channel, float celsius);
+    bool addRelativeHumidity(uint8_t channel, float percent);
+    bool addAccelerometer(uint8_t channel, float x, float y, float z);
+    bool addBarometricPressure(uint8_t channel, float hectopascal);
+    bool addGyrometer(uint8_t channel, float x, float y, float z);
+    bool addGPS(uint8_t channel, float latitude, float longitude, float altitude);
+    bool addGPS(uint8_t channel, GeoLocation location);
+
+    virtual unsigned char* getBytes();
+    virtual unsigned int getSize();
+    virtual void reset();
+
+    // Layout of a type: number of values, bytes per value, resolution and
+    // whether it is signed. Returns false for unknown types.
+    static bool getLayout(uint8_t type, unsigned int &values, unsigned int &size, float &resolution, bool &isSigned);
+
+private:
+    unsigned char *buffer;
+    unsigned int capacity;
+    unsigned int offset = 0;
+
+    bool add(uint8_t channel, uint8_t type, const float *values);
+};
+
+class LppReader {
+public:
+    LppReader(const unsigned char *bytes, unsigned int size);
+
+    // Yields the next value; values holds up to 3 numbers (count of them
+    // set). Returns false at the end or on malformed input (see isValid()).
+    bool next(uint8_t &channel, uint8_t &type, float *values, unsigned int &count);
+    bool isValid();
+
+private:
+    const unsigned char *bytes;
+    unsigned int size;
+    unsigned int offset = 0;
+    bool valid = true;
+};
+
+#endif
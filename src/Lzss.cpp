@@ -0,0 +1,138 @@
+#include <string.h>
+
+#include "Lzss.h"
+#include "ByteOrder.h"
+
+const unsigned int LzssEncoder::windowSize;
+const unsigned int LzssEncoder::minLength;
+const unsigned int LzssEncoder::maxLength;
+
+static const uint8_t offsetBits = 8;
+static const uint8_t lengthBits = 4;
+
+LzssEncoder::LzssEncoder(const unsigned char *dictionary, unsigned int dictionarySize) {
+    // Only the tail of a dictionary is ever within reach.
+    if (dictionarySize > windowSize) {
+        dictionary += dictionarySize - windowSize;
+        dictionarySize = windowSize;
+    }
+    this->dictionary = dictionary;
+    this->dictionarySize = dictionarySize;
+    begin(0, 0);
+}
+
+void LzssEncoder::begin(unsigned char *out, unsigned int capacity) {
+    if (dictionarySize > 0) {
+        memcpy(buffer, dictionary, dictionarySize);
+    }
+    position = end = dictionarySize;
+
+    this->out = out;
+    this->capacity = capacity;
+    bit = 0;
+    overflow = false;
+    if (out != 0) {
+        memset(out, 0, capacity);
+    }
+}
+
+bool LzssEncoder::write(unsigned char value) {
+    while (end - position >= maxLength) {
+        encodeToken();
+    }
+    if (end == sizeof(buffer)) {
+        // Everything before position - windowSize is out of reach.
+        unsigned int drop = position - windowSize;
+        memmove(buffer, buffer + drop, end - drop);
+        position -= drop;
+        end -= drop;
+    }
+    buffer[end++] = value;
+    return !overflow;
+}
+
+bool LzssEncoder::write(const unsigned char *data, unsigned int length) {
+    for (unsigned int i = 0; i < length; ++i) {
+        write(data[i]);
+    }
+    return !overflow;
+}
+
+unsigned int LzssEncoder::finish() {
+    while (position < end) {
+        encodeToken();
+    }
+    return overflow ? 0 : (bit + 7) / 8;
+}
+
+void LzssEncoder::encodeToken() {
+    unsigned int available = end - position;
+    unsigned int longest = available < maxLength ? available : maxLength;
+    unsigned int first = position > windowSize ? position - windowSize : 0;
+
+    unsigned int bestLength = 0;
+    unsigned int bestDistance = 0;
+    for (unsigned int candidate = first; candidate < position; ++candidate) {
+        // Matches may run into the lookahead; the decoder copies byte by byte.
+        unsigned int length = 0;
+        while (length < longest && buffer[candidate + length] == buffer[position + length]) {
+            length++;
+        }
+        if (length > bestLength) {
+            bestLength = length;
+            bestDistance = position - candidate;
+            if (length == longest) break;
+        }
+    }
+
+    if (bestLength >= minLength) {
+        writeBits(0, 1);
+        writeBits(bestDistance - 1, offsetBits);
+        writeBits(bestLength - minLength, lengthBits);
+        position += bestLength;
+    } else {
+        writeBits(0x100 | buffer[position], 1 + 8);
+        position++;
+    }
+}
+
+void LzssEncoder::writeBits(uint32_t value, uint8_t bits) {
+    if (bit + bits > (unsigned long)capacity * 8) {
+        overflow = true;
+        return;
+    }
+    storeBits(out, bit, value, bits);
+    bit += bits;
+}
+
+unsigned int lzssDecode(const unsigned char *in, unsigned int length, unsigned char *out, unsigned int capacity,
+                        const unsigned char *dictionary, unsigned int dictionarySize) {
+    unsigned long bits = (unsigned long)length * 8;
+    unsigned long bit = 0;
+    unsigned int size = 0;
+
+    while (bits - bit >= 1 + 8) {
+        if (loadBits(in, bit++, 1)) {
+            if (size >= capacity)
+                return 0;
+            out[size++] = loadBits(in, bit, 8);
+            bit += 8;
+            continue;
+        }
+
+        if (bits - bit < offsetBits + lengthBits)
+            return 0;
+
+        unsigned int distance = loadBits(in, bit, offsetBits) + 1;
+        unsigned int count = loadBits(in, bit + offsetBits, lengthBits) + LzssEncoder::minLength;
+        bit += offsetBits + lengthBits;
+
+        if (distance > size + dictionarySize || size + count > capacity)
+            return 0;
+
+        for (unsigned int i = 0; i < count; ++i, ++size) {
+            out[size] = distance > size ? dictionary[dictionarySize + size - distance] : out[size - distance];
+        }
+    }
+    return size;
+}
@@ -0,0 +1,64 @@
+#ifndef LZSS_H_
+#define LZSS_H_
+
+#include <stdint.h>
+
+// LZSS with a 256 byte window, for the text that ends up in payloads (status
+// messages, error strings, firmware identifiers). The output is a stream of
+// MSB-first tokens:
+//
+//   1 + 8 bits     literal byte
+//   0 + 8 + 4 bits match: distance - 1, length - 3 (3 to 18 bytes)
+//
+// Trailing bits of the last byte are zero and shorter than any token.
+//
+// Both sides can be primed with the same static dictionary, which then acts
+// as history the first bytes can refer to. Strings that occur in every frame
+// (asset names, common words) compress well that way even in short frames.
+//
+// This header has no Arduino dependencies, so backend tools can use
+// lzssDecode to expand what the device sent.
+
+class LzssEncoder {
+public:
+    static const unsigned int windowSize = 256;
+    static const unsigned int minLength = 3;
+    static const unsigned int maxLength = 18;
+
+    LzssEncoder(const unsigned char *dictionary = 0, unsigned int dictionarySize = 0);
+
+    // Starts a new stream written to out.
+    void begin(unsigned char *out, unsigned int capacity);
+
+    // Returns false once out has overflowed; the stream is then unusable.
+    bool write(unsigned char value);
+    bool write(const unsigned char *data, unsigned int length);
+
+    // Flushes what is still buffered and returns the stream size, or 0 if
+    // it did not fit.
+    unsigned int finish();
+
+private:
+    const unsigned char *dictionary;
+    unsigned int dictionarySize;
+
+    // Window followed by lookahead; about 300 bytes in total.
+    unsigned char buffer[windowSize + maxLength];
+    unsigned int position; // Next byte to encode
+    unsigned int end;
+
+    unsigned char *out;
+    unsigned int capacity;
+    unsigned long bit;
+    bool overflow;
+
+    void encodeToken();
+    void writeBits(uint32_t value, uint8_t bits);
+};
+
+// Expands a stream from LzssEncoder into out. Returns the expanded size, or
+// 0 if the input is malformed or does not fit.
+unsigned int lzssDecode(const unsigned char *in, unsigned int length, unsigned char *out, unsigned int capacity,
+                        const unsigned char *dictionary = 0, unsigned int dictionarySize = 0);
+
+#endif
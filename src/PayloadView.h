@@ -0,0 +1,41 @@
+#ifndef PAYLOAD_VIEW_H_
+#define PAYLOAD_VIEW_H_
+
+#include "Payload.h"
+
+#include <string.h>
+
+// Sends bytes that live elsewhere (a DMA or sensor buffer, a const table,
+// another payload) without copying them or allocating:
+//
+//   static const unsigned char hello[] = { 0x48, 0x69 };
+//   PayloadView view(hello, sizeof(hello));
+//   modem.send(view);
+//
+// modem.send(bytes, size) does the same in one call.
+//
+// The view does not own the bytes; they must stay valid while it is used.
+// Data placed in PROGMEM on AVR has to be copied to RAM first.
+class PayloadView : public Payload {
+public:
+    PayloadView() : bytes(0), size(0) { }
+    PayloadView(const unsigned char *bytes, unsigned int size) : bytes(bytes), size(size) { }
+    explicit PayloadView(const char *text) : bytes(reinterpret_cast<const unsigned char *>(text)), size(strlen(text)) { }
+
+    // The current frame of another payload, which must not change meanwhile.
+    explicit PayloadView(Payload &payload) : bytes(payload.getBytes()), size(payload.getSize()) { }
+
+    // Payload hands out non-const bytes, but nothing that takes a Payload
+    // writes through them.
+    virtual unsigned char* getBytes() { return const_cast<unsigned char *>(bytes); }
+    virtual unsigned int getSize() { return size; }
+
+    // Empties the view; the bytes themselves are left alone.
+    virtual void reset() { size = 0; }
+
+private:
+    const unsigned char *bytes;
+    unsigned int size;
+};
+
+#endif
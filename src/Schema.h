@@ -0,0 +1,239 @@
+#ifndef SCHEMA_H_
+#define SCHEMA_H_
+
+#include "Arduino.h"
+#include "BinaryPayload.h"
+#include "ByteOrder.h"
+
+#include <string.h>
+#include <stdint.h>
+
+// Fixed binary layout for BinaryPayload, resolved at compile time.
+//
+//   Schema<Field<float>, Field<bool>, Field<char[5]>> schema("random", "toggle", "message");
+//   schema.encode(payload, 17.56, true, "hello");
+//   schema.describe(Serial); // prints the matching ABCL conversion
+//
+// Values are stored big-endian, exactly like BinaryPayload::add, so a schema
+// can replace a sequence of add() calls without changing the frame.
+//
+// Flag, Bits<N> and Scaled<Min, Max, Scale> are packed MSB-first like
+// BinaryPayload::addBits; a Field<T> that follows them starts on the next
+// byte boundary.
+
+template<typename T> struct NumericField {
+    typedef T Type;
+    static const bool aligned = true;
+    static const unsigned int bits = sizeof(T) * 8;
+
+    static void write(unsigned char *out, unsigned long bit, T value) {
+        storeBigEndian(out + bit / 8, value);
+    }
+};
+
+template<typename T> struct IntegerField : NumericField<T> {
+    static void describe(Print &out) {
+        out.print("        \"type\": \"integer\"");
+        if ((T)-1 < (T)0) {
+            out.print(",\n        \"signed\": true");
+        }
+    }
+};
+
+template<typename T> struct Field;
+
+template<> struct Field<bool> {
+    typedef bool Type;
+    static const bool aligned = true;
+    static const unsigned int bits = 8;
+
+    static void write(unsigned char *out, unsigned long bit, bool value) {
+        out[bit / 8] = value ? 1 : 0;
+    }
+
+    static void describe(Print &out) { out.print("        \"type\": \"boolean\""); }
+};
+
+template<> struct Field<float> : NumericField<float> {
+    static void describe(Print &out) { out.print("        \"type\": \"number\""); }
+};
+
+template<> struct Field<double> : NumericField<double> {
+    static void describe(Print &out) { out.print("        \"type\": \"number\""); }
+};
+
+// Specialized on the fundamental types, so that every intN_t alias resolves
+// to exactly one of them on both AVR and ARM.
+template<> struct Field<signed char> : IntegerField<signed char> { };
+template<> struct Field<unsigned char> : IntegerField<unsigned char> { };
+template<> struct Field<short> : IntegerField<short> { };
+template<> struct Field<unsigned short> : IntegerField<unsigned short> { };
+template<> struct Field<int> : IntegerField<int> { };
+template<> struct Field<unsigned int> : IntegerField<unsigned int> { };
+template<> struct Field<long> : IntegerField<long> { };
+template<> struct Field<unsigned long> : IntegerField<unsigned long> { };
+template<> struct Field<long long> : IntegerField<long long> { };
+template<> struct Field<unsigned long long> : IntegerField<unsigned long long> { };
+
+// Fixed-length text, truncated or zero-padded to exactly N bytes.
+template<unsigned int N> struct Field<char[N]> {
+    typedef const char *Type;
+    static const bool aligned = true;
+    static const unsigned int bits = N * 8;
+
+    static void write(unsigned char *out, unsigned long bit, const char *value) {
+        strncpy(reinterpret_cast<char *>(out + bit / 8), value, N);
+    }
+
+    static void describe(Print &out) { out.print("        \"type\": \"string\""); }
+};
+
+// A single packed boolean.
+struct Flag {
+    typedef bool Type;
+    static const bool aligned = false;
+    static const unsigned int bits = 1;
+
+    static void write(unsigned char *out, unsigned long bit, bool value) {
+        storeBits(out, bit, value ? 1 : 0, 1);
+    }
+
+    static void describe(Print &out) { out.print("        \"type\": \"boolean\""); }
+};
+
+// An unsigned integer of N bits.
+template<unsigned int N> struct Bits {
+    static_assert(N > 0 && N <= 32, "Bits<N> takes 1 to 32 bits.");
+
+    typedef uint32_t Type;
+    static const bool aligned = false;
+    static const unsigned int bits = N;
+
+    static void write(unsigned char *out, unsigned long bit, uint32_t value) {
+        storeBits(out, bit, value, N);
+    }
+
+    static void describe(Print &out) { out.print("        \"type\": \"integer\""); }
+};
+
+template<unsigned long n> struct BitWidth {
+    static const unsigned int value = 1 + BitWidth<n / 2>::value;
+};
+template<> struct BitWidth<1> { static const unsigned int value = 1; };
+template<> struct BitWidth<0> { static const unsigned int value = 1; };
+
+// A number in [Min / Scale, Max / Scale] with a resolution of 1 / Scale,
+// stored in the fewest bits that cover the range. For a battery voltage
+// between 2.00 V and 4.20 V in 10 mV steps: Scaled<200, 420, 100>.
+template<long Min, long Max, unsigned long Scale = 1> struct Scaled {
+    static_assert(Max > Min, "Scaled<Min, Max, Scale> needs Max > Min.");
+
+    typedef float Type;
+    static const bool aligned = false;
+    static const unsigned int bits = BitWidth<(unsigned long)(Max - Min)>::value;
+
+    static void write(unsigned char *out, unsigned long bit, float value) {
+        float scaled = value * Scale;
+        if (scaled < Min) scaled = Min;
+        if (scaled > Max) scaled = Max;
+        storeBits(out, bit, (uint32_t)(scaled - Min + 0.5f), bits);
+    }
+
+    static void describe(Print &out) {
+        out.print("        \"type\": \"number\",\n        \"calculation\": \"(val ");
+        out.print(Min < 0 ? "- " : "+ ");
+        out.print(Min < 0 ? -Min : Min);
+        out.print(") / ");
+        out.print(Scale);
+        out.print("\"");
+    }
+};
+
+template<unsigned long bit, typename... Fields> struct SchemaLayout;
+
+template<unsigned long bit> struct SchemaLayout<bit> {
+    static const unsigned long end = bit;
+    static const bool packed = false;
+
+    static void encode(unsigned char *) { }
+    static void describe(Print &, const char *const *) { }
+};
+
+template<unsigned long bit, typename F, typename... Rest> struct SchemaLayout<bit, F, Rest...> {
+    static const unsigned long start = F::aligned ? (bit + 7) / 8 * 8 : bit;
+    typedef SchemaLayout<start + F::bits, Rest...> Next;
+    static const unsigned long end = Next::end;
+    static const bool packed = !F::aligned || Next::packed;
+
+    static void encode(unsigned char *out, typename F::Type value, typename Rest::Type... rest) {
+        F::write(out, start, value);
+        Next::encode(out, rest...);
+    }
+
+    static void describe(Print &out, const char *const *names) {
+        out.print("    {\n      \"asset\": \"");
+        out.print(names[0]);
+        out.print("\",\n      \"value\": {\n        \"byte\": ");
+        out.print(start / 8);
+        if (F::aligned) {
+            out.print(",\n        \"bytelength\": ");
+            out.print(F::bits / 8);
+        } else {
+            out.print(",\n        \"bit\": ");
+            out.print(start % 8);
+            out.print(",\n        \"bitlength\": ");
+            out.print(F::bits);
+        }
+        out.print(",\n");
+        F::describe(out);
+        out.print(sizeof...(Rest) > 0 ? "\n      }\n    },\n" : "\n      }\n    }\n");
+        Next::describe(out, names + 1);
+    }
+};
+
+template<typename... Fields> class Schema {
+public:
+    static const unsigned int count = sizeof...(Fields);
+    static const unsigned int size = (SchemaLayout<0, Fields...>::end + 7) / 8;
+
+    template<typename... Names> Schema(Names... assetNames) : names{assetNames...} {
+        static_assert(sizeof...(Names) == sizeof...(Fields), "Schema needs one asset name per field.");
+    }
+
+    // Appends one frame to the payload. Capacity is checked once for the
+    // whole layout; the fields themselves are written unchecked.
+    bool encode(BinaryPayload &payload, typename Fields::Type... values) {
+        unsigned char *out = payload.reserve(size);
+        if (out == NULL)
+            return false;
+
+        encode(out, values...);
+        return true;
+    }
+
+    // Writes exactly `size` bytes into buffer.
+    void encode(unsigned char *buffer, typename Fields::Type... values) {
+        if (SchemaLayout<0, Fields...>::packed) {
+            memset(buffer, 0, size);
+        }
+        SchemaLayout<0, Fields...>::encode(buffer, values...);
+    }
+
+    // Prints the ABCL conversion for this layout. Packed fields are given
+    // as "bit" (counted from the most significant bit of "byte") and
+    // "bitlength".
+    void describe(Print &out) {
+        out.print("{\n  \"sense\": [\n");
+        SchemaLayout<0, Fields...>::describe(out, names);
+        out.print("  ]\n}\n");
+    }
+
+    const char *getAssetName(unsigned int index) {
+        return index < count ? names[index] : NULL;
+    }
+
+private:
+    const char *names[sizeof...(Fields)];
+};
+
+#endif
@@ -0,0 +1,300 @@
+#include <string.h>
+
+#include "TimeSeriesPayload.h"
+#include "ByteOrder.h"
+#include "Varint.h"
+
+// array(2), uint32 base timestamp, map(assets)
+static const unsigned int headerSize = 1 + 5 + 1;
+
+static unsigned int headSize(unsigned int length) {
+    return length < 24 ? 1 : (length < 256 ? 2 : 3);
+}
+
+static unsigned int writeHead(unsigned char *out, unsigned char majorType, unsigned int length) {
+    majorType <<= 5;
+    if (length < 24) {
+        out[0] = majorType | length;
+        return 1;
+    } else if (length < 256) {
+        out[0] = majorType | 24;
+        out[1] = length;
+        return 2;
+    } else {
+        out[0] = majorType | 25;
+        out[1] = length >> 8;
+        out[2] = length;
+        return 3;
+    }
+}
+
+static float decimalScale(unsigned char decimals) {
+    float scale = 1;
+    while (decimals-- > 0) {
+        scale *= 10;
+    }
+    return scale;
+}
+
+const unsigned int TimeSeriesPayload::maxAssets;
+
+TimeSeriesPayload::TimeSeriesPayload(unsigned int capacity, unsigned int assets) {
+    if (assets > maxAssets) {
+        assets = maxAssets;
+    }
+    // Without room for the header there is no frame to add assets to.
+    if (capacity < headerSize) {
+        assets = 0;
+    }
+    this->capacity = capacity;
+    this->buffer = new unsigned char[capacity];
+    this->columnCapacity = assets;
+    this->columns = new Column[assets];
+    reset();
+}
+
+TimeSeriesPayload::~TimeSeriesPayload() {
+    delete[] buffer;
+    delete[] columns;
+}
+
+unsigned char *TimeSeriesPayload::getBytes() {
+    return buffer;
+}
+
+unsigned int TimeSeriesPayload::getSize() {
+    return count > 0 ? size : 0;
+}
+
+unsigned int TimeSeriesPayload::getCount() {
+    return count;
+}
+
+void TimeSeriesPayload::reset() {
+    count = 0;
+    size = 0;
+    if (capacity < headerSize) {
+        return;
+    }
+
+    buffer[0] = 0x82;
+    buffer[1] = 0x1A;
+    storeBigEndian(buffer + 2, (uint32_t)0);
+    size = headerSize + writeHead(buffer + 6, 5, columnCount) - 1;
+
+    for (unsigned int i = 0; i < columnCount; ++i) {
+        Column &column = columns[i];
+        column.timeLength = 0;
+        column.valueLength = 0;
+        size += writeHead(buffer + size, 3, column.nameLength);
+        memcpy(buffer + size, column.name, column.nameLength);
+        size += column.nameLength;
+        buffer[size++] = 0x83;
+        buffer[size++] = column.decimals;
+        buffer[size++] = 0x40;
+        buffer[size++] = 0x40;
+    }
+}
+
+int TimeSeriesPayload::addAsset(const char *assetName, unsigned char decimals) {
+    unsigned int nameLength = strlen(assetName);
+    unsigned int entrySize = headSize(nameLength) + nameLength + 4;
+    if (columnCount >= columnCapacity || decimals > 9 || size + entrySize > capacity)
+        return -1;
+
+    Column &column = columns[columnCount];
+    column.name = assetName;
+    column.nameLength = nameLength;
+    column.decimals = decimals;
+    column.timeLength = 0;
+    column.valueLength = 0;
+    columnCount++;
+
+    // Entries are appended behind the existing ones; only the map length
+    // in the header changes.
+    writeHead(buffer + 6, 5, columnCount);
+    size += writeHead(buffer + size, 3, nameLength);
+    memcpy(buffer + size, assetName, nameLength);
+    size += nameLength;
+    buffer[size++] = 0x83;
+    buffer[size++] = decimals;
+    buffer[size++] = 0x40;
+    buffer[size++] = 0x40;
+    return columnCount - 1;
+}
+
+unsigned int TimeSeriesPayload::columnOffset(unsigned int asset) {
+    unsigned int offset = headerSize;
+    for (unsigned int i = 0; i < asset; ++i) {
+        Column &column = columns[i];
+        offset += headSize(column.nameLength) + column.nameLength + 2
+            + headSize(column.timeLength) + column.timeLength
+            + headSize(column.valueLength) + column.valueLength;
+    }
+    return offset;
+}
+
+// Grows the byte string at headerOffset by dataLength bytes, widening its
+// header if needed and shifting everything behind it.
+void TimeSeriesPayload::insert(unsigned int headerOffset, unsigned int length, const unsigned char *data, unsigned int dataLength) {
+    unsigned int oldHead = headSize(length);
+    unsigned int newHead = headSize(length + dataLength);
+    unsigned int growth = newHead - oldHead + dataLength;
+    unsigned int end = headerOffset + oldHead + length;
+
+    memmove(buffer + end + growth, buffer + end, size - end);
+    if (newHead != oldHead) {
+        memmove(buffer + headerOffset + newHead, buffer + headerOffset + oldHead, length);
+    }
+    writeHead(buffer + headerOffset, 2, length + dataLength);
+    memcpy(buffer + headerOffset + newHead + length, data, dataLength);
+    size += growth;
+}
+
+bool TimeSeriesPayload::add(int asset, float value, uint32_t timestamp) {
+    if (asset < 0 || (unsigned int)asset >= columnCount)
+        return false;
+
+    Column &column = columns[asset];
+    bool first = column.timeLength == 0;
+    uint32_t base = count == 0 ? timestamp : baseTimestamp;
+    uint32_t previousTimestamp = first ? base : column.lastTimestamp;
+    uint32_t elapsed = timestamp > previousTimestamp ? timestamp - previousTimestamp : 0;
+
+    float scaled = value * decimalScale(column.decimals);
+    int32_t raw = (int32_t)(scaled + (scaled < 0 ? -0.5f : 0.5f));
+
+    unsigned char timeDelta[maxVarintSize];
+    unsigned char valueDelta[maxVarintSize];
+    unsigned int timeDeltaLength = encodeVarint(timeDelta, elapsed);
+    unsigned int valueDeltaLength = encodeVarint(valueDelta, zigzagEncode(raw - (first ? 0 : column.lastValue)));
+
+    unsigned int growth = headSize(column.timeLength + timeDeltaLength) - headSize(column.timeLength) + timeDeltaLength
+        + headSize(column.valueLength + valueDeltaLength) - headSize(column.valueLength) + valueDeltaLength;
+    if (size + growth > capacity)
+        return false;
+
+    unsigned int timeOffset = columnOffset(asset) + headSize(column.nameLength) + column.nameLength + 2;
+    insert(timeOffset, column.timeLength, timeDelta, timeDeltaLength);
+    column.timeLength += timeDeltaLength;
+
+    unsigned int valueOffset = timeOffset + headSize(column.timeLength) + column.timeLength;
+    insert(valueOffset, column.valueLength, valueDelta, valueDeltaLength);
+    column.valueLength += valueDeltaLength;
+
+    if (count == 0) {
+        baseTimestamp = timestamp;
+        storeBigEndian(buffer + 2, baseTimestamp);
+    }
+    column.lastTimestamp = previousTimestamp + elapsed;
+    column.lastValue = raw;
+    count++;
+    return true;
+}
+
+TimeSeriesReader::TimeSeriesReader(const unsigned char *bytes, unsigned int size) {
+    this->bytes = bytes;
+    this->size = size;
+}
+
+bool TimeSeriesReader::isValid() {
+    return valid;
+}
+
+bool TimeSeriesReader::readHead(unsigned char majorType, uint32_t &value) {
+    if (offset >= size || (bytes[offset] >> 5) != majorType)
+        return false;
+
+    unsigned char minorType = bytes[offset++] & 31;
+    unsigned int length = minorType < 24 ? 0 : (minorType == 24 ? 1 : (minorType == 25 ? 2 : (minorType == 26 ? 4 : 8)));
+    if (length == 8 || size - offset < length)
+        return false;
+
+    value = length == 0 ? minorType : 0;
+    for (unsigned int i = 0; i < length; ++i) {
+        value = (value << 8) | bytes[offset++];
+    }
+    return true;
+}
+
+bool TimeSeriesReader::readAsset() {
+    uint32_t length, fields, decimals, timeLength, valueLength;
+
+    if (!readHead(3, length) || size - offset < length)
+        return false;
+    name = (const char *)bytes + offset;
+    nameLength = length;
+    offset += length;
+
+    if (!readHead(4, fields) || fields != 3 || !readHead(0, decimals) || decimals > 9)
+        return false;
+    scale = decimalScale(decimals);
+
+    if (!readHead(2, timeLength) || size - offset < timeLength)
+        return false;
+    times = bytes + offset;
+    timesLeft = timeLength;
+    offset += timeLength;
+
+    if (!readHead(2, valueLength) || size - offset < valueLength)
+        return false;
+    values = bytes + offset;
+    valuesLeft = valueLength;
+    offset += valueLength;
+
+    lastTimestamp = baseTimestamp;
+    lastValue = 0;
+    return true;
+}
+
+bool TimeSeriesReader::next(const char *&assetName, unsigned int &nameLength, float &value, uint32_t &timestamp) {
+    if (!valid)
+        return false;
+
+    if (offset == 0) {
+        uint32_t items, assets;
+        if (!readHead(4, items) || items != 2 || !readHead(0, baseTimestamp) || !readHead(5, assets)) {
+            valid = false;
+            return false;
+        }
+        assetsLeft = assets;
+    }
+
+    while (timesLeft == 0) {
+        if (valuesLeft != 0) {
+            valid = false;
+            return false;
+        }
+        if (assetsLeft == 0) {
+            valid = offset == size;
+            return false;
+        }
+        if (!readAsset()) {
+            valid = false;
+            return false;
+        }
+        assetsLeft--;
+    }
+
+    uint32_t elapsed;
+    int32_t delta;
+    unsigned int timeUsed = decodeVarint(times, timesLeft, elapsed);
+    unsigned int valueUsed = decodeSignedVarint(values, valuesLeft, delta);
+    if (timeUsed == 0 || valueUsed == 0) {
+        valid = false;
+        return false;
+    }
+    times += timeUsed;
+    timesLeft -= timeUsed;
+    values += valueUsed;
+    valuesLeft -= valueUsed;
+
+    lastTimestamp += elapsed;
+    lastValue += delta;
+
+    assetName = name;
+    nameLength = this->nameLength;
+    value = lastValue / scale;
+    timestamp = lastTimestamp;
+    return true;
+}
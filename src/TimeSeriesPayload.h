@@ -0,0 +1,106 @@
+#ifndef TIME_SERIES_PAYLOAD_H_
+#define TIME_SERIES_PAYLOAD_H_
+
+#include "Payload.h"
+
+#include <stdint.h>
+
+// Many samples per uplink, stored column by column. The frame is CBOR:
+//
+//   [ base timestamp,
+//     { "asset": [ decimals, h'time deltas', h'value deltas' ], ... } ]
+//
+// Time deltas are LEB128 varints in seconds, each relative to the previous
+// sample of the same asset (the first one to the base timestamp). Value
+// deltas are zigzag varints of value * 10^decimals, each relative to the
+// previous sample of the same asset (the first one to 0). See Varint.h.
+//
+// The frame is kept in its final form while samples are added, so
+// getBytes() is free and no second buffer is needed. TimeSeriesReader
+// expands a frame again and has no Arduino dependencies.
+class TimeSeriesPayload : public Payload {
+public:
+    static const unsigned int maxAssets = 23;
+
+    // A capacity below 7 bytes cannot hold the frame header; addAsset() then
+    // always fails.
+    TimeSeriesPayload(unsigned int capacity = 51, unsigned int assets = 8);
+    ~TimeSeriesPayload();
+    TimeSeriesPayload(const TimeSeriesPayload &) = delete;
+    TimeSeriesPayload &operator=(const TimeSeriesPayload &) = delete;
+
+    // Declares an asset and returns its index, or -1 if no more fit.
+    // Values are kept with the given number of decimals.
+    int addAsset(const char *assetName, unsigned char decimals = 0);
+
+    // Appends a sample. Returns false, leaving the frame untouched, when it
+    // no longer fits: send, reset() and add it again. Per asset, timestamps
+    // are expected not to go backwards.
+    bool add(int asset, float value, uint32_t timestamp);
+    unsigned int getCount();
+
+    virtual unsigned char* getBytes();
+    virtual unsigned int getSize();
+
+    // Drops all samples; declared assets are kept.
+    virtual void reset();
+
+private:
+    struct Column {
+        const char *name;
+        unsigned int nameLength;
+        unsigned char decimals;
+        uint32_t lastTimestamp;
+        int32_t lastValue;
+        unsigned int timeLength;
+        unsigned int valueLength;
+    };
+
+    unsigned char *buffer;
+    unsigned int capacity;
+    unsigned int size = 0;
+    unsigned int count = 0;
+
+    Column *columns;
+    unsigned int columnCapacity;
+    unsigned int columnCount = 0;
+    uint32_t baseTimestamp = 0;
+
+    unsigned int columnOffset(unsigned int asset);
+    void insert(unsigned int headerOffset, unsigned int length, const unsigned char *data, unsigned int dataLength);
+};
+
+class TimeSeriesReader {
+public:
+    TimeSeriesReader(const unsigned char *bytes, unsigned int size);
+
+    // Yields every sample, asset by asset. The asset name points into the
+    // frame and is not null-terminated. Returns false at the end of the frame
+    // or on malformed input (see isValid()).
+    bool next(const char *&assetName, unsigned int &nameLength, float &value, uint32_t &timestamp);
+    bool isValid();
+
+private:
+    const unsigned char *bytes;
+    unsigned int size;
+    unsigned int offset = 0;
+    bool valid = true;
+
+    uint32_t baseTimestamp = 0;
+    unsigned int assetsLeft = 0;
+
+    const char *name = nullptr;
+    unsigned int nameLength = 0;
+    float scale = 1;
+    const unsigned char *times = nullptr;
+    unsigned int timesLeft = 0;
+    const unsigned char *values = nullptr;
+    unsigned int valuesLeft = 0;
+    uint32_t lastTimestamp = 0;
+    int32_t lastValue = 0;
+
+    bool readHead(unsigned char majorType, uint32_t &value);
+    bool readAsset();
+};
+
+#endif
@@ -0,0 +1,133 @@
+#include "TrackPayload.h"
+#include "ByteOrder.h"
+#include "Varint.h"
+
+const unsigned char TrackPayload::altitudeFlag;
+
+TrackPayload::TrackPayload(unsigned int capacity) {
+    this->capacity = capacity;
+    this->buffer = new unsigned char[capacity];
+}
+
+TrackPayload::~TrackPayload() {
+    delete[] buffer;
+}
+
+unsigned char *TrackPayload::getBytes() {
+    return buffer;
+}
+
+unsigned int TrackPayload::getSize() {
+    return offset;
+}
+
+unsigned int TrackPayload::getCount() {
+    return count;
+}
+
+void TrackPayload::reset() {
+    offset = 0;
+    count = 0;
+}
+
+bool TrackPayload::add(GeoLocation location, uint32_t timestamp) {
+    int32_t latitude = location.getCompactLatitude();
+    int32_t longitude = location.getCompactLongitude();
+    int16_t altitude = location.getCompactAltitude();
+
+    if (count == 0) {
+        if (1 + 4 + location.getCompactSize() > capacity)
+            return false;
+
+        hasAltitude = location.hasAltitude();
+        buffer[0] = hasAltitude ? altitudeFlag : 0;
+        storeBigEndian(buffer + 1, timestamp);
+        offset = 5 + location.toCompact(buffer + 5);
+    } else {
+        uint32_t elapsed = timestamp > lastTimestamp ? timestamp - lastTimestamp : 0;
+        uint32_t deltaLatitude = zigzagEncode(latitude - lastLatitude);
+        uint32_t deltaLongitude = zigzagEncode(longitude - lastLongitude);
+        uint32_t deltaAltitude = zigzagEncode(altitude - lastAltitude);
+
+        unsigned int size = varintSize(elapsed) + varintSize(deltaLatitude) + varintSize(deltaLongitude);
+        if (hasAltitude) size += varintSize(deltaAltitude);
+        if (offset + size > capacity)
+            return false;
+
+        offset += encodeVarint(buffer + offset, elapsed);
+        offset += encodeVarint(buffer + offset, deltaLatitude);
+        offset += encodeVarint(buffer + offset, deltaLongitude);
+        if (hasAltitude) {
+            offset += encodeVarint(buffer + offset, deltaAltitude);
+        }
+        timestamp = lastTimestamp + elapsed;
+    }
+
+    lastTimestamp = timestamp;
+    lastLatitude = latitude;
+    lastLongitude = longitude;
+    lastAltitude = altitude;
+    count++;
+    return true;
+}
+
+TrackReader::TrackReader(const unsigned char *bytes, unsigned int size) {
+    this->bytes = bytes;
+    this->size = size;
+}
+
+bool TrackReader::isValid() {
+    return valid;
+}
+
+bool TrackReader::readDelta(int32_t &delta) {
+    unsigned int used = decodeSignedVarint(bytes + offset, size - offset, delta);
+    offset += used;
+    return used > 0;
+}
+
+bool TrackReader::next(GeoLocation &location, uint32_t &timestamp) {
+    if (!valid || offset >= size)
+        return false;
+
+    if (offset == 0) {
+        hasAltitude = (bytes[0] & TrackPayload::altitudeFlag) != 0;
+        unsigned int compactSize = hasAltitude ? GeoLocation::compactSizeWithAltitude : GeoLocation::compactSize;
+        if (size < 5 + compactSize) {
+            valid = false;
+            return false;
+        }
+
+        lastTimestamp = loadBigEndian<uint32_t>(bytes + 1);
+        lastLatitude = loadInt24(bytes + 5);
+        lastLongitude = loadInt24(bytes + 8);
+        if (hasAltitude) {
+            lastAltitude = (int16_t)(((uint16_t)bytes[11] << 8) | bytes[12]);
+        }
+        offset = 5 + compactSize;
+    } else {
+        uint32_t elapsed;
+        int32_t deltaLatitude, deltaLongitude, deltaAltitude = 0;
+        unsigned int used = decodeVarint(bytes + offset, size - offset, elapsed);
+        offset += used;
+        if (used == 0 || !readDelta(deltaLatitude) || !readDelta(deltaLongitude)
+                || (hasAltitude && !readDelta(deltaAltitude))) {
+            valid = false;
+            return false;
+        }
+
+        lastTimestamp += elapsed;
+        // Wrapping, so that a corrupt frame cannot overflow.
+        lastLatitude = (int32_t)((uint32_t)lastLatitude + (uint32_t)deltaLatitude);
+        lastLongitude = (int32_t)((uint32_t)lastLongitude + (uint32_t)deltaLongitude);
+        lastAltitude = (int16_t)((uint32_t)lastAltitude + (uint32_t)deltaAltitude);
+    }
+
+    timestamp = lastTimestamp;
+    if (hasAltitude) {
+        location = GeoLocation::fromCompact(lastLatitude, lastLongitude, lastAltitude);
+    } else {
+        location = GeoLocation::fromCompact(lastLatitude, lastLongitude);
+    }
+    return true;
+}
@@ -0,0 +1,76 @@
+#ifndef TRACK_PAYLOAD_H_
+#define TRACK_PAYLOAD_H_
+
+#include "Payload.h"
+#include "GeoLocation.h"
+
+#include <stdint.h>
+
+// A batch of GPS fixes in one uplink. The first fix is stored in full, every
+// following one as the difference to its predecessor, which for a tracker
+// reporting every few tens of seconds is typically 3-4 bytes per fix:
+//
+//   byte 0       flags (0x01: fixes carry an altitude)
+//   bytes 1-4    timestamp of the first fix, seconds, big-endian
+//   bytes 5-     first fix in compact form (see GeoLocation), 6 or 8 bytes
+//   then per fix varint(seconds since previous fix), zigzag varint deltas of
+//   latitude, longitude and, if flagged, altitude in compact units.
+//
+// TrackReader decodes it again and has no Arduino dependencies.
+class TrackPayload : public Payload {
+public:
+    static const unsigned char altitudeFlag = 0x01;
+
+    TrackPayload(unsigned int capacity = 51); // Lowest LoRa payload length.
+    ~TrackPayload();
+    TrackPayload(const TrackPayload &) = delete;
+    TrackPayload &operator=(const TrackPayload &) = delete;
+
+    // Appends a fix. Returns false, leaving the batch untouched, once the
+    // fix no longer fits: send the batch, reset() and add the fix again.
+    // Timestamps are expected not to go backwards.
+    bool add(GeoLocation location, uint32_t timestamp);
+    unsigned int getCount();
+
+    virtual unsigned char* getBytes();
+    virtual unsigned int getSize();
+    virtual void reset();
+
+private:
+    unsigned char *buffer;
+    unsigned int capacity;
+    unsigned int offset = 0;
+    unsigned int count = 0;
+
+    bool hasAltitude = false;
+    uint32_t lastTimestamp = 0;
+    int32_t lastLatitude = 0;
+    int32_t lastLongitude = 0;
+    int16_t lastAltitude = 0;
+};
+
+class TrackReader {
+public:
+    TrackReader(const unsigned char *bytes, unsigned int size);
+
+    // Yields the fixes in order; returns false at the end of the batch or
+    // on malformed input (see isValid()).
+    bool next(GeoLocation &location, uint32_t &timestamp);
+    bool isValid();
+
+private:
+    const unsigned char *bytes;
+    unsigned int size;
+    unsigned int offset = 0;
+    bool valid = true;
+
+    bool hasAltitude = false;
+    uint32_t lastTimestamp = 0;
+    int32_t lastLatitude = 0;
+    int32_t lastLongitude = 0;
+    int16_t lastAltitude = 0;
+
+    bool readDelta(int32_t &delta);
+};
+
+#endif
@@ -0,0 +1,399 @@
+#include "UplinkJournal.h"
+#include "PayloadView.h"
+#include "ByteOrder.h"
+#include "Varint.h"
+
+const unsigned int UplinkJournal::headerSize;
+const unsigned int UplinkJournal::maxMessageSize;
+const unsigned char UplinkJournal::defaultBatchPort;
+const unsigned char UplinkJournal::defaultMaxAttempts;
+
+// Record: status, length, port, crc, timestamp (4 bytes), data. Sending
+// clears bits of the status only, so it needs no erase on flash.
+static const unsigned char statusPending = 0xA5;
+static const unsigned char statusSent = 0x05;
+
+// End marker: status, tail position (2 bytes), crc. A wrap marker is its
+// status byte alone and means the next record is at position 0.
+static const unsigned char statusEnd = 0xE7;
+static const unsigned char statusWrap = 0xC3;
+static const unsigned int endSize = 4;
+
+static bool isValidPort(unsigned char port) {
+    return port > 0 && port <= 223;
+}
+
+UplinkJournal::UplinkJournal(JournalStorage &storage, unsigned int frameCapacity) : storage(storage) {
+    this->frameCapacity = frameCapacity;
+    this->buffer = new unsigned char[frameCapacity];
+}
+
+UplinkJournal::~UplinkJournal() {
+    delete[] buffer;
+}
+
+void UplinkJournal::setBatchPort(unsigned char port) {
+    batchPort = port;
+}
+
+void UplinkJournal::setMaxAttempts(unsigned char attempts) {
+    maxAttempts = attempts;
+}
+
+unsigned int UplinkJournal::getPending() {
+    return pending;
+}
+
+unsigned long UplinkJournal::getDropped() {
+    return dropped;
+}
+
+unsigned long UplinkJournal::getUsed() {
+    return wrapped ? (unsigned long)head + (wrapAt - tail) : (unsigned long)head - tail;
+}
+
+bool UplinkJournal::readHeader(uint16_t position, Record &record) {
+    unsigned char header[headerSize];
+    if ((unsigned long)position + headerSize + endSize > size || !storage.read(position, header, headerSize))
+        return false;
+
+    record.status = header[0];
+    record.length = header[1];
+    record.port = header[2];
+    record.crc = header[3];
+    record.timestamp = loadBigEndian<uint32_t>(header + 4);
+
+    if (record.status != statusPending && record.status != statusSent)
+        return false;
+    return (unsigned long)position + headerSize + record.length + endSize <= size;
+}
+
+// Reads the data into data, or only checks it when data is null.
+bool UplinkJournal::readData(uint16_t position, const Record &record, unsigned char *data) {
+    unsigned char chunk[16];
+    unsigned char fields[6] = { record.length, record.port };
+    storeBigEndian(fields + 2, record.timestamp);
+    uint8_t crc = journalCrc(0, fields, sizeof(fields));
+
+    position += headerSize;
+    for (unsigned int done = 0; done < record.length; ) {
+        unsigned int length = record.length - done < sizeof(chunk) ? record.length - done : sizeof(chunk);
+        unsigned char *target = data ? data + done : chunk;
+        if (!storage.read(position + done, target, length))
+            return false;
+        crc = journalCrc(crc, target, length);
+        done += length;
+    }
+    return crc == record.crc;
+}
+
+bool UplinkJournal::writeEnd(uint16_t position) {
+    unsigned char marker[endSize] = { statusEnd };
+    storeBigEndian(marker + 1, tail);
+    marker[3] = journalCrc(0, marker + 1, 2);
+    return storage.write(position, marker, endSize);
+}
+
+bool UplinkJournal::markSent(uint16_t position) {
+    pending--;
+    return storage.write(position, &statusSent, 1);
+}
+
+uint16_t UplinkJournal::advance(uint16_t position, const Record &record) {
+    position += headerSize + record.length;
+    return wrapped && position == wrapAt ? 0 : position;
+}
+
+// Follows valid records from `from` until `to`; returns where it stopped.
+uint16_t UplinkJournal::walk(uint16_t from, uint16_t to, bool tally) {
+    Record record;
+    while (from != to && readHeader(from, record) && readData(from, record, 0)) {
+        if (tally) {
+            count++;
+            if (record.status == statusPending) pending++;
+        }
+        from += headerSize + record.length;
+    }
+    return from;
+}
+
+// Gives up on everything stored, when the records no longer read back.
+void UplinkJournal::forget() {
+    dropped += pending;
+    count = 0;
+    pending = 0;
+    wrapped = false;
+    tail = head;
+    writeEnd(head);
+}
+
+void UplinkJournal::dropOldest() {
+    Record record;
+    if (!readHeader(tail, record)) {
+        forget();
+        return;
+    }
+    if (record.status == statusPending) {
+        pending--;
+        dropped++;
+    }
+    if (tail == failing) failures = 0;
+    count--;
+    tail = advance(tail, record);
+    if (tail == 0) wrapped = false;
+}
+
+bool UplinkJournal::begin() {
+    unsigned long available = storage.getSize();
+    size = available > 0xFFFF ? 0xFFFF : available;
+    count = 0;
+    pending = 0;
+    failures = 0;
+    wrapped = false;
+    if (size < headerSize + 1 + endSize)
+        return false;
+
+    // The current lap runs from 0 to the end marker, which knows where the
+    // previous lap, if any is left, starts.
+    head = walk(0, size, false);
+    unsigned char marker[endSize];
+    bool marked = storage.read(head, marker, endSize) && marker[0] == statusEnd && journalCrc(0, marker + 1, 2) == marker[3];
+    tail = marked ? loadBigEndian<uint16_t>(marker + 1) : 0;
+    uint16_t storedTail = tail;
+
+    if (tail > head) {
+        wrapAt = walk(tail, size, true);
+        wrapped = wrapAt != tail;
+        if (!wrapped) {
+            tail = 0;
+        } else if (!storage.read(wrapAt, marker, 1) || marker[0] != statusWrap) {
+            // The wrap marker is written last when an append wraps.
+            if (!storage.write(wrapAt, &statusWrap, 1))
+                return false;
+        }
+    }
+    if (!wrapped && walk(tail, head, false) != head) {
+        tail = 0;
+    }
+    walk(wrapped ? 0 : tail, head, true);
+
+    if (!marked || tail != storedTail)
+        return writeEnd(head);
+    return true;
+}
+
+bool UplinkJournal::append(Payload &payload, unsigned char port, uint32_t timestamp) {
+    return append(payload.getBytes(), payload.getSize(), port, timestamp);
+}
+
+bool UplinkJournal::append(const unsigned char *bytes, unsigned int length, unsigned char port, uint32_t timestamp) {
+    if (!isValidPort(port) || length > maxMessageSize || length > frameCapacity || headerSize + length + endSize > size)
+        return false;
+    uint16_t need = headerSize + length + endSize;
+
+    uint16_t storedTail = tail;
+
+    // Make room after head, overwriting the oldest records, and continue at
+    // 0 when the record does not fit before the end of storage.
+    while (wrapped && (unsigned long)head + need > tail) {
+        dropOldest();
+    }
+    uint16_t start = head;
+    if (!wrapped && (unsigned long)head + need > size) {
+        while (count > 0 && tail < need) {
+            dropOldest();
+        }
+        start = 0;
+    }
+    bool wrapping = start != head && count > 0;
+    if (count == 0) {
+        tail = start;
+    } else if (wrapping) {
+        wrapped = true;
+        wrapAt = head;
+    }
+
+    unsigned char header[headerSize] = { statusPending, (unsigned char)length, port };
+    storeBigEndian(header + 4, timestamp);
+    header[3] = journalCrc(journalCrc(0, header + 1, 2), header + 4, 4);
+    header[3] = journalCrc(header[3], bytes, length);
+
+    // The status byte goes last: until then the record reads as invalid.
+    // The end marker is rewritten first when records were dropped, so that
+    // it never points at a record about to be overwritten, and when the
+    // record goes to 0, which still holds a record of the previous lap.
+    uint16_t end = start + headerSize + length;
+    if (((start != head || tail != storedTail) && !writeEnd(start)) || !writeEnd(end))
+        return false;
+    if (!storage.write(start + 1, header + 1, headerSize - 1) || (length > 0 && !storage.write(start + headerSize, bytes, length)) || !storage.write(start, header, 1))
+        return false;
+    if (wrapping && !storage.write(head, &statusWrap, 1))
+        return false;
+
+    head = end;
+    count++;
+    pending++;
+    return true;
+}
+
+unsigned int UplinkJournal::drain(Device<LoRaOptions> &device, unsigned int maxSize, unsigned int maxMessages) {
+    if (maxSize == 0 || maxSize > frameCapacity) maxSize = frameCapacity;
+
+    unsigned int sent = 0;
+    uint16_t position = tail;
+    while (pending > 0 && sent < maxMessages) {
+        Record record;
+        if (!readHeader(position, record)) {
+            forget();
+            return sent;
+        }
+        if (record.status != statusPending) {
+            position = advance(position, record);
+            continue;
+        }
+
+        // Room for the batch header in front, so a batch needs no copying.
+        // A message that was refused before goes alone, so that it cannot
+        // hold back the others.
+        bool retry = failures > 0 && position == failing;
+        unsigned int dataOffset = 4 + 1 + 1 + varintSize(record.length);
+        bool batching = batchPort != 0 && !retry && dataOffset + record.length <= maxSize;
+        unsigned char *data = batching ? buffer + dataOffset : buffer;
+        if (record.length > frameCapacity || !isValidPort(record.port) || !readData(position, record, data)) {
+            dropped++;
+            markSent(position);
+            position = advance(position, record);
+            continue;
+        }
+        if (record.length > maxSize)
+            return sent;
+
+        uint16_t first = position;
+        uint16_t end = advance(position, record);
+        unsigned int messages = 1;
+        unsigned int offset = dataOffset + record.length;
+        uint32_t last = record.timestamp;
+        while (batching && messages < pending && messages < maxMessages - sent && end != head) {
+            Record next;
+            if (!readHeader(end, next))
+                break;
+            if (next.status != statusPending) {
+                end = advance(end, next);
+                continue;
+            }
+
+            uint32_t elapsed = zigzagEncode((int32_t)(next.timestamp - last));
+            unsigned int prefix = 1 + varintSize(elapsed) + varintSize(next.length);
+            if (offset + prefix + next.length > maxSize || !readData(end, next, buffer + offset + prefix))
+                break;
+
+            buffer[offset] = next.port;
+            encodeVarint(buffer + offset + 1, elapsed);
+            encodeVarint(buffer + offset + 1 + varintSize(elapsed), next.length);
+            offset += prefix + next.length;
+            last = next.timestamp;
+            messages++;
+            end = advance(end, next);
+        }
+
+        LoRaOptions options = device.getOptions();
+        bool success;
+        if (messages == 1) {
+            options.port = record.port;
+            PayloadView payload(data, record.length);
+            success = device.send(payload, options);
+        } else {
+            storeBigEndian(buffer, record.timestamp);
+            buffer[4] = record.port;
+            buffer[5] = 0;
+            encodeVarint(buffer + 6, record.length);
+            options.port = batchPort;
+            PayloadView payload(buffer, offset);
+            success = device.send(payload, options);
+        }
+        if (!success) {
+            if (!retry) {
+                failing = first;
+                failures = 0;
+            }
+            failures++;
+            if (messages == 1 && maxAttempts > 0 && failures >= maxAttempts) {
+                dropped++;
+                markSent(first);
+                failures = 0;
+            }
+            return sent;
+        }
+        failures = 0;
+
+        for (position = first; position != end; position = advance(position, record)) {
+            if (!readHeader(position, record)) {
+                forget();
+                return sent + messages;
+            }
+            if (record.status == statusPending) {
+                markSent(position);
+            }
+        }
+        sent += messages;
+    }
+    return sent;
+}
+
+bool UplinkJournal::send(Device<LoRaOptions> &device, Payload &payload, unsigned char port, uint32_t timestamp, unsigned int maxSize) {
+    if (!isValidPort(port))
+        return false;
+
+    if (pending > 0) {
+        drain(device, maxSize);
+    }
+    if (pending == 0 && (maxSize == 0 || payload.getSize() <= maxSize)) {
+        LoRaOptions options = device.getOptions();
+        options.port = port;
+        if (device.send(payload, options))
+            return true;
+    }
+    append(payload, port, timestamp);
+    return false;
+}
+
+UplinkBatchReader::UplinkBatchReader(const unsigned char *bytes, unsigned int size) {
+    this->bytes = bytes;
+    this->size = size;
+    if (size < 4) {
+        valid = false;
+    } else {
+        lastTimestamp = loadBigEndian<uint32_t>(bytes);
+    }
+}
+
+bool UplinkBatchReader::isValid() {
+    return valid;
+}
+
+bool UplinkBatchReader::next(unsigned char &port, uint32_t &timestamp, const unsigned char *&data, unsigned int &length) {
+    if (!valid || offset >= size)
+        return false;
+
+    int32_t elapsed;
+    uint32_t messageLength;
+    unsigned int used;
+    port = bytes[offset++];
+    if ((used = decodeSignedVarint(bytes + offset, size - offset, elapsed)) == 0) {
+        valid = false;
+        return false;
+    }
+    offset += used;
+    if ((used = decodeVarint(bytes + offset, size - offset, messageLength)) == 0 || messageLength > size - offset - used) {
+        valid = false;
+        return false;
+    }
+    offset += used;
+
+    lastTimestamp += elapsed;
+    timestamp = lastTimestamp;
+    data = bytes + offset;
+    length = messageLength;
+    offset += messageLength;
+    return true;
+}
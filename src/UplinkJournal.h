@@ -0,0 +1,137 @@
+#ifndef UPLINK_JOURNAL_H_
+#define UPLINK_JOURNAL_H_
+
+#include "Device.h"
+#include "LoRaOptions.h"
+#include "Payload.h"
+#include "JournalStorage.h"
+
+#include <stdint.h>
+
+// Keeps uplinks that could not be sent, because the join failed or the modem
+// answered no_free_ch or not_joined, and sends them once the network is back:
+//
+//   UplinkJournal journal(storage);
+//   journal.begin();
+//   ...
+//   journal.send(modem, payload, port, now, modem.getDataRateMaxPayloadSize());
+//
+// Storage is a ring of variable-length records. Every record is written
+// once; when the ring is full the oldest records are overwritten (pending
+// ones are counted by getDropped()). Marking a record as sent rewrites its
+// status byte only, by clearing bits, so writes are spread over the whole
+// storage and no byte is written more than a few times per lap.
+//
+// After a power loss, begin() finds the records again. A record whose
+// write was interrupted is discarded; an interrupted append can also cost
+// the records of the previous lap.
+//
+// Messages drained together are batched into one frame on batchPort:
+//
+//   bytes 0-3    timestamp of the first message, big-endian
+//   then per message: port, zigzag varint(seconds since the previous
+//   message), varint(length), the bytes
+//
+// UplinkBatchReader decodes it again and has no Arduino dependencies. A
+// single message is sent as it was, on its own port.
+class UplinkJournal {
+public:
+    static const unsigned int headerSize = 8;
+    static const unsigned int maxMessageSize = 255;
+    static const unsigned char defaultBatchPort = 223;
+    static const unsigned char defaultMaxAttempts = 8;
+
+    UplinkJournal(JournalStorage &storage, unsigned int frameCapacity = 51); // Lowest LoRa payload length.
+    ~UplinkJournal();
+    UplinkJournal(const UplinkJournal &) = delete;
+    UplinkJournal &operator=(const UplinkJournal &) = delete;
+
+    // Finds the records in storage, formatting it if there are none. Returns
+    // false if the storage cannot be read or written, or is too small.
+    bool begin();
+
+    // Stores a message to send later. Returns false if the port is not
+    // 1-223, the message is larger than maxMessageSize or the frame
+    // capacity, or the storage fails.
+    bool append(Payload &payload, unsigned char port, uint32_t timestamp);
+    bool append(const unsigned char *bytes, unsigned int size, unsigned char port, uint32_t timestamp);
+
+    // Sends pending messages, oldest first, until the device refuses one or
+    // maxMessages are sent. maxSize limits each frame, e.g. to
+    // modem.getDataRateMaxPayloadSize(); 0 means the frame capacity. A
+    // message larger than maxSize waits for a faster data rate. A message
+    // the device refuses is retried on its own, outside a batch, and given
+    // up after maxAttempts refusals in a row (counted by getDropped()).
+    // Returns the number of messages sent.
+    unsigned int drain(Device<LoRaOptions> &device, unsigned int maxSize = 0, unsigned int maxMessages = 0xFFFF);
+
+    // Drains the journal, then sends the payload; if anything is still
+    // pending, the payload is larger than maxSize or the send fails, the
+    // payload is journalled instead. Returns true if the payload itself was
+    // sent. A port outside 1-223 is refused, and is not journalled.
+    bool send(Device<LoRaOptions> &device, Payload &payload, unsigned char port, uint32_t timestamp, unsigned int maxSize = 0);
+
+    // 0 sends every message on its own port, without batching.
+    void setBatchPort(unsigned char port);
+
+    // 0 retries a refused message for ever.
+    void setMaxAttempts(unsigned char attempts);
+
+    unsigned int getPending();
+    unsigned long getDropped();
+    unsigned long getUsed(); // Bytes held by stored records
+
+private:
+    JournalStorage &storage;
+    unsigned char *buffer;
+    unsigned int frameCapacity;
+    unsigned char batchPort = defaultBatchPort;
+    unsigned char maxAttempts = defaultMaxAttempts;
+
+    uint16_t size = 0;
+    uint16_t head = 0;  // Position of the end marker
+    uint16_t tail = 0;  // Oldest record still in storage
+    uint16_t wrapAt = 0; // Position of the wrap marker while wrapped
+    bool wrapped = false; // tail lies beyond head, in the previous lap
+    unsigned int count = 0;
+    unsigned int pending = 0;
+    unsigned long dropped = 0;
+    uint16_t failing = 0;        // Record the device last refused
+    unsigned char failures = 0;  // Refusals of it in a row
+
+    struct Record {
+        unsigned char status;
+        unsigned char length;
+        unsigned char port;
+        unsigned char crc;
+        uint32_t timestamp;
+    };
+
+    bool readHeader(uint16_t position, Record &record);
+    bool readData(uint16_t position, const Record &record, unsigned char *data);
+    bool writeEnd(uint16_t position);
+    bool markSent(uint16_t position);
+    uint16_t advance(uint16_t position, const Record &record);
+    uint16_t walk(uint16_t from, uint16_t to, bool tally);
+    void dropOldest();
+    void forget();
+};
+
+class UplinkBatchReader {
+public:
+    UplinkBatchReader(const unsigned char *bytes, unsigned int size);
+
+    // Yields the messages in order; returns false at the end of the batch or
+    // on malformed input (see isValid()). data points into the batch.
+    bool next(unsigned char &port, uint32_t &timestamp, const unsigned char *&data, unsigned int &length);
+    bool isValid();
+
+private:
+    const unsigned char *bytes;
+    unsigned int size;
+    unsigned int offset = 4;
+    bool valid = true;
+    uint32_t lastTimestamp = 0;
+};
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef VARINT_H_
+#define VARINT_H_
+
+#include <stdint.h>
+
+// LEB128 variable-length integers: 7 bits per byte, least significant group
+// first, high bit set on every byte but the last. Values below 128 take one
+// byte and the layout is the same on every platform. Signed values are
+// zigzag-mapped first (0, -1, 1, -2, ... -> 0, 1, 2, 3, ...) so that small
+// negative numbers stay short too.
+//
+// This header has no Arduino dependencies, so backend tools can include it
+// to decode what the device encoded.
+
+static const unsigned int maxVarintSize = 5; // 32-bit values
+
+inline uint32_t zigzagEncode(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+inline int32_t zigzagDecode(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+inline unsigned int varintSize(uint32_t value) {
+    unsigned int size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+// Writes value to out and returns the number of bytes used.
+inline unsigned int encodeVarint(unsigned char *out, uint32_t value) {
+    unsigned int size = 0;
+    while (value >= 0x80) {
+        out[size++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    out[size++] = value;
+    return size;
+}
+
+// Reads a value from at most length bytes of in. Returns the number of bytes
+// consumed, or 0 if the input is truncated or longer than 32 bits.
+inline unsigned int decodeVarint(const unsigned char *in, unsigned int length, uint32_t &value) {
+    value = 0;
+    for (unsigned int i = 0; i < length && i < maxVarintSize; ++i) {
+        // The fifth byte only has room for bits 28 to 31.
+        if (i == maxVarintSize - 1 && (in[i] & 0x70))
+            return 0;
+        value |= (uint32_t)(in[i] & 0x7F) << (7 * i);
+        if ((in[i] & 0x80) == 0) {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+inline unsigned int decodeSignedVarint(const unsigned char *in, unsigned int length, int32_t &value) {
+    uint32_t raw;
+    unsigned int size = decodeVarint(in, length, raw);
+    value = zigzagDecode(raw);
+    return size;
+}
+
+#endif